@@ -0,0 +1,44 @@
+/** @file almacen.h
+ *  @brief Almacen compacto de pulsos.
+ *
+ *  Todas las muestras de la captura se guardan en una unica arena, con el
+ *  tamaño justo segun el valid_samples de cada pulso. Cada pulso ocupa su
+ *  tabla tal como viene en el archivo: los pares I/Q de la componente
+ *  vertical seguidos de los de la horizontal.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef ALMACEN_H
+#define ALMACEN_H
+
+#include <stddef.h>
+
+struct AlmacenPulsos{
+	int num_pulsos;
+	size_t capacidad;
+	float *arena;
+	size_t *offsets;
+	int *valid_samples;
+};
+/*!< Almacen de pulsos. El pulso p comienza en arena + offsets[p] y ocupa
+4*valid_samples[p] floats; offsets tiene num_pulsos+1 elementos. */
+
+void crear_almacen(struct AlmacenPulsos *almacen, int num_pulsos, size_t num_floats);
+void liberar_almacen(struct AlmacenPulsos *almacen);
+int ubicar_pulso(struct AlmacenPulsos *almacen, int pulso, int valid_samples);
+
+/**
+* @brief Tabla de un pulso del almacen.
+*
+* @param almacen Almacen de pulsos.
+* @param pulso Numero de pulso, ya ubicado con ubicar_pulso().
+* @return Puntero a los 4*valid_samples floats de la tabla del pulso. Se
+* escribe directamente con fread o pread al leer el archivo.
+*/
+static inline float *
+tabla_pulso(const struct AlmacenPulsos *almacen, int pulso){
+	return almacen->arena + almacen->offsets[pulso];
+}
+
+#endif
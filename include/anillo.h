@@ -0,0 +1,54 @@
+/** @file anillo.h
+ *  @brief Buffer circular acotado y sin locks entre el lector y los hilos de calculo.
+ *
+ *  Cola MPMC de tamaño fijo (algoritmo de Vyukov): cada celda tiene un numero
+ *  de secuencia que indica si esta libre para el productor o lista para un
+ *  consumidor, por lo que reservar y tomar celdas cuesta una operacion
+ *  atomica y ningun mutex. Las celdas guardan un bloque de pulsos crudos, que
+ *  el consumidor procesa en el lugar antes de devolverla.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef ANILLO_H
+#define ANILLO_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define ANILLO_CELDAS_POR_HILO 2
+/*!< Celdas del anillo por hilo consumidor, para que el lector pueda ir un
+bloque adelante de cada uno. */
+
+struct CeldaAnillo{
+	atomic_size_t secuencia;
+	size_t posicion;
+	int inicio;
+	int cantidad;
+	int muestras[PULSOS_POR_BLOQUE];
+	float *crudo;
+};
+/*!< Celda del anillo: un bloque de hasta PULSOS_POR_BLOQUE pulsos consecutivos
+de la captura, desde el pulso inicio. La tabla del pulso p ocupa
+crudo + 4*radar.max_muestras*p. */
+
+struct Anillo{
+	size_t capacidad;
+	struct CeldaAnillo *celdas;
+	_Alignas(64) atomic_size_t escritura;
+	_Alignas(64) atomic_size_t lectura;
+	_Alignas(64) atomic_int cancelado;
+};
+/*!< Anillo de celdas. capacidad es potencia de 2; escritura y lectura son las
+proximas posiciones a reservar por el productor y a tomar por un consumidor,
+cada una en su propia linea de cache. */
+
+void crear_anillo(struct Anillo *anillo, int consumidores);
+void liberar_anillo(struct Anillo *anillo);
+struct CeldaAnillo *reservar_celda(struct Anillo *anillo);
+void publicar_celda(struct Anillo *anillo, struct CeldaAnillo *celda);
+struct CeldaAnillo *tomar_celda(struct Anillo *anillo, size_t total);
+void devolver_celda(struct Anillo *anillo, struct CeldaAnillo *celda);
+void cancelar_anillo(struct Anillo *anillo);
+
+#endif
@@ -0,0 +1,37 @@
+/** @file backend.h
+ *  @brief Registro de backends del calculo.
+ *
+ *  Un unico binario contiene todas las variantes del procesamiento: ejecucion
+ *  escalar o con OpenMP, kernels escalares o vectoriales (registrados en
+ *  simd.c), motor de autocorrelacion y metodo de lectura de la captura. Cada
+ *  eje se elige por nombre desde la linea de comandos, o con "auto" segun la
+ *  CPU y el tamaño del problema.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#define FFT_FACTOR_SIMD 32
+/*!< El motor automatico elige la FFT cuando N*L supera FFT_FACTOR_SIMD veces
+M*log2(M), siendo M el largo de la FFT, si hay kernels vectoriales. Medido en
+capturas de 1000 a 16000 pulsos contra el motor simd con AVX-512. */
+#define FFT_FACTOR_ESCALAR 3
+/*!< Igual que FFT_FACTOR_SIMD, contra el motor directo, si no hay kernels vectoriales. */
+
+struct EntradaBackend{
+	const char *nombre;
+	int valor;
+};
+/*!< Entrada de un registro de backends: nombre para la linea de comandos y valor. */
+
+int motor_por_nombre(const char nombre[]);
+const char *nombre_motor(int motor);
+int lectura_por_nombre(const char nombre[]);
+const char *nombre_lectura(int lectura);
+const char *nombre_ejecucion(int hilos);
+int elegir_motor(int motor, int num_pulsos, int num_lags);
+int elegir_lectura(int lectura, char file_name[]);
+
+#endif
@@ -0,0 +1,56 @@
+/** @file captura.h
+ *  @brief Lectura de capturas del radar mapeadas en memoria.
+ *
+ *  Permite mapear el archivo de pulsos con mmap y acceder a cada pulso como
+ *  una vista (puntero y longitud) sobre el mapeo, sin copiar las muestras.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef CAPTURA_H
+#define CAPTURA_H
+
+#include <stddef.h>
+#include <string.h>
+#include "../include/indice.h"
+
+struct VistaPulso{
+	int valid_samples;
+	const unsigned char *datos;
+};
+/*!< Vista de un pulso dentro del mapeo. datos apunta a la tabla de
+4*valid_samples floats que sigue al encabezado uint16_t del pulso. */
+
+struct Captura{
+	int fd;
+	size_t tamano;
+	const unsigned char *base;
+	int num_pulsos;
+	struct VistaPulso *pulsos;
+};
+/*!< Archivo de pulsos mapeado en memoria, y las vistas de cada uno de sus pulsos.
+Si la captura se leyo con cargar_captura(), base es un buffer anonimo y fd vale -1. */
+
+int abrir_captura(char file_name[], const struct IndicePulsos *indice, struct Captura *captura);
+int cargar_captura(char file_name[], const struct IndicePulsos *indice, struct Captura *captura);
+void cerrar_captura(struct Captura *captura);
+
+/**
+* @brief Lee un float de la tabla de un pulso mapeado.
+*
+* Las tablas no quedan alineadas a 4 bytes (cada una sigue a un encabezado de
+* 2 bytes), por lo que el valor se obtiene con memcpy, que el compilador
+* traduce a una unica carga no alineada.
+*
+* @param pulso Vista del pulso.
+* @param indice Posicion del float dentro de la tabla (0 a 4*valid_samples-1).
+* @return El valor leido.
+*/
+static inline float
+leer_muestra(const struct VistaPulso *pulso, int indice){
+	float valor;
+	memcpy(&valor, pulso->datos + (size_t)indice*sizeof(float), sizeof(float));
+	return valor;
+}
+
+#endif
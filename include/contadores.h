@@ -0,0 +1,54 @@
+/** @file contadores.h
+ *  @brief Contadores de hardware por etapa y por hilo.
+ *
+ *  Con CONTADORES definido (make CONTADORES=1), cada region de etapa lee al
+ *  entrar y al salir los contadores de perf_event_open de cada hilo de
+ *  OpenMP: ciclos, instrucciones, fallos de la cache de ultimo nivel y ciclos
+ *  detenidos. Sin CONTADORES las regiones no generan codigo, y contadores.c
+ *  no se compila.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef CONTADORES_H
+#define CONTADORES_H
+
+#define REGION_LECTURA 0
+/*!< Lectura de la captura (leer_archivo, o apertura de la captura con mmap o lectura asincrona). */
+#define REGION_MODULO 1
+/*!< Calculo de modulos y promedios por gate (promedio_y_valor_absoluto). */
+#define REGION_AUTOCORRELACION 2
+/*!< Calculo de la autocorrelacion de todos los gates. */
+#define REGION_ESCRITURA 3
+/*!< Escritura del archivo de resultados (guardar_archivo). */
+#define NUM_REGIONES 4
+/*!< Numero de regiones instrumentadas. */
+
+#ifdef CONTADORES
+
+#define MAX_HILOS_CONTADOS 256
+/*!< Numero maximo de hilos cuyos contadores se registran. */
+
+void iniciar_region(int region);
+void terminar_region(int region);
+void informar_contadores(void);
+
+/**
+* @brief Region instrumentada: la sentencia o bloque que sigue se mide como la etapa indicada.
+*
+* El bloque se ejecuta una vez, entre iniciar_region() y terminar_region().
+* Salir de el con return, break o goto saltea terminar_region(), por lo que
+* solo debe terminar normalmente o con exit().
+*/
+#define REGION(region) \
+	for (int region_activa_ = (iniciar_region(region), 1); region_activa_; region_activa_ = (terminar_region(region), 0))
+#define INFORMAR_CONTADORES() informar_contadores()
+
+#else
+
+#define REGION(region)
+#define INFORMAR_CONTADORES() ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,41 @@
+/** @file fft.h
+ *  @brief Autocorrelacion por FFT (teorema de Wiener–Khinchin).
+ *
+ *  Calcula todos los desplazamientos de la autocorrelacion de un gate en
+ *  O(N log N): transformada directa, espectro de potencia y transformada
+ *  inversa, sobre el vector completado con ceros.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef FFT_H
+#define FFT_H
+
+#define FFT_TOLERANCIA 1e-5
+/*!< Error maximo del motor FFT respecto del calculo directo, relativo al
+valor de la autocorrelacion en el desplazamiento 0 (la energia del vector).
+La mayor parte del error proviene de la acumulacion en float del calculo
+directo, que crece con el numero de pulsos. Solo vale para columnas finitas:
+un NaN o infinito se extenderia a todos los desplazamientos del gate, por lo
+que calcular_autocorrelacion_fft() calcula esos gates en forma directa. */
+
+struct PlanFFT{
+	int len;
+	int num_lags;
+	int n;
+	double *coseno;
+	double *seno;
+	int *inverso_bits;
+};
+/*!< Plan de FFT para vectores de len elementos, de los que se calculan los
+primeros num_lags desplazamientos. n es la menor potencia de 2 mayor o igual
+a len + num_lags, para que la correlacion circular no se superponga.
+Las tablas se calculan una sola vez y se comparten entre todos los gates. */
+
+void crear_plan_fft(struct PlanFFT *plan, int len, int num_lags);
+void destruir_plan_fft(struct PlanFFT *plan);
+double *crear_trabajo_fft(const struct PlanFFT *plan);
+void autocorrelacion_fft(const struct PlanFFT *plan, const float v[], const float h[],
+	float resultado_v[], float resultado_h[], double trabajo[]);
+
+#endif
@@ -0,0 +1,72 @@
+/** @file formato.h
+ *  @brief Formatos del archivo de resultados.
+ *
+ *  El formato original (FORMATO_V1) guarda el numero de desplazamientos en un
+ *  uint16_t, que se desborda con mas de 65535 pulsos. El formato versionado
+ *  comienza con un encabezado con el numero de pulsos, de gates y de
+ *  desplazamientos en 32 bits y la codificacion de los vectores, seguido de
+ *  una tabla con el offset de cada gate, de modo que un lector puede ir
+ *  directamente a uno de ellos. Los vectores pueden guardarse como float, como
+ *  half (la mitad del tamaño) o comprimidos sin perdida.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef FORMATO_H
+#define FORMATO_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define FORMATO_MAGIA "RACF"
+/*!< Primeros bytes de un archivo de resultados versionado. */
+#define FORMATO_VERSION 2
+/*!< Version del formato versionado. El formato original es la version 1. */
+
+struct EncabezadoFormato{
+	char magia[4];
+	uint16_t version;
+	uint16_t codificacion;
+	uint32_t num_pulsos;
+	uint32_t num_gates;
+	uint32_t num_lags;
+	uint32_t reservado;
+};
+/*!< Encabezado del formato versionado, de 24 bytes. Le sigue una tabla de
+num_gates+1 offsets (uint64_t), medidos desde el inicio del encabezado: el
+gate i ocupa los bytes [offset[i], offset[i+1]), con su vector vertical y luego
+el horizontal. El ultimo offset es el tamaño del bloque, por lo que el modo de
+ventana deslizante puede escribir un bloque a continuacion del otro. */
+
+struct Formato{
+	int codificacion;
+	int num_pulsos;
+	int num_lags;
+};
+/*!< Descripcion de un bloque de resultados a escribir. */
+
+struct BloqueResultados{
+	int codificacion;
+	int num_pulsos;
+	int num_gates;
+	int num_lags;
+	float *vertical;
+	float *horizontal;
+};
+/*!< Bloque de resultados leido de un archivo. El desplazamiento l del gate g
+esta en vertical[g*num_lags + l] y horizontal[g*num_lags + l]. En el formato
+original no se guardan ni el numero de pulsos (queda en 0) ni el de gates, que
+se toma de radar.num_gates. */
+
+void preparar_formato(struct Formato *formato, int codificacion, int num_pulsos, int num_lags);
+int codificacion_formato(const char nombre[]);
+size_t bytes_encabezado_formato(void);
+size_t bytes_gate_formato(const struct Formato *formato);
+size_t cota_gate_formato(const struct Formato *formato);
+size_t codificar_gate(const struct Formato *formato, const struct Gate *gate, unsigned char destino[]);
+void armar_encabezado_formato(const struct Formato *formato, struct EncabezadoFormato *encabezado);
+int escribir_resultados(FILE *f, struct Gate gates[], const struct Formato *formato);
+int leer_resultados(FILE *f, struct BloqueResultados *bloque);
+void liberar_resultados(struct BloqueResultados *bloque);
+
+#endif
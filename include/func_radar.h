@@ -0,0 +1,80 @@
+/** @file func_radar.h
+ *  @brief Libreria del motor de procesamiento.
+ *
+ *  Libreria del programa, constantes, estructuras y prototipos de
+ *  funciones.
+ *
+ *  @author Facundo Maero
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <omp.h>
+#include <pthread.h>
+#include "../include/radar.h"
+#include "../include/captura.h"
+#include "../include/almacen.h"
+#include "../include/matriz.h"
+#include "../include/fft.h"
+#include "../include/simd.h"
+#include "../include/incremental.h"
+#include "../include/ventana.h"
+#include "../include/lote.h"
+#include "../include/formato.h"
+#include "../include/salida.h"
+#include "../include/anillo.h"
+#include "../include/backend.h"
+#include "../include/contadores.h"
+
+#define MAX_NUM_THREADS 201
+/*!< Numero maximo de hilos para ejecutar el programa. */
+#define BLOQUE_FLUJO (16*PULSOS_POR_BLOQUE)
+/*!< Numero de pulsos que se leen juntos en el modo de procesamiento en flujo.
+Se reparten entre los hilos de a PULSOS_POR_BLOQUE, por lo que alcanza para 16 hilos. */
+
+struct LecturaLote{
+	char *ruta;
+	int indice_flag;
+	struct AlmacenPulsos almacen;
+	struct Captura captura;
+	int mapeada;
+	int num_pulsos;
+	int error;
+	int en_curso;
+	pthread_t hilo;
+};
+/*!< Lectura de una captura del modo por lotes, hecha en un hilo aparte
+mientras se calcula la captura anterior. Si mapeada, la captura no entra en
+memoria y se mapeo en captura en lugar de leerse en almacen. */
+
+int leer_numero_pulsos_archivo(char file_name[], int* num_pulso, uint64_t* size_bytes);
+int leer_archivo(char file_name[], struct AlmacenPulsos *almacen, int num_pulsos, uint64_t len_file);
+int leer_archivo_indice(char file_name[], struct AlmacenPulsos *almacen, const struct IndicePulsos *indice);
+float valor_absoluto(float u, float v);
+void promedio_y_valor_absoluto(const struct AlmacenPulsos *almacen, struct Gate gates[]);
+void promedio_y_valor_absoluto_captura(const struct Captura *captura, struct Gate gates[]);
+int procesar_archivo_desde(char file_name[], struct Gate gates[], uint64_t offset, int primer_pulso, int num_pulsos);
+int procesar_archivo_flujo(char file_name[], struct Gate gates[], int num_pulsos);
+int procesar_archivo_pipeline(char file_name[], struct Gate gates[], int num_pulsos);
+int leer_archivo_incremental(char file_name[], struct Gate gates[], int max_lags, struct EstadoIncremental *estado, int *num_pulsos);
+void autocorrelacion(float vector[],int len, int num_lags, float resultado[]);
+void calcular_autocorrelacion(struct Gate gates[], int num_pulsos, int num_lags, struct Salida *salida);
+void calcular_autocorrelacion_fft(struct Gate gates[], int num_pulsos, int num_lags, struct Salida *salida);
+void calcular_autocorrelacion_incremental(struct Gate gates[], struct EstadoIncremental *estado, int num_pulsos, struct Salida *salida);
+void calcular_autocorrelacion_simd(struct Gate gates[], int num_pulsos, int num_lags, struct Salida *salida);
+void calcular_autocorrelacion_motor(struct Gate gates[], int motor, int num_pulsos, int num_lags, struct Salida *salida);
+int guardar_archivo(struct Gate gates[], char filename[], const struct Formato *formato);
+int procesar_lote(const struct Lote *lote, struct Gate gates[], const struct Opciones *opciones, char sufijo[]);
+int procesar_ventana(FILE *entrada, struct Gate gates[], int capacidad, int paso, double plazo, int max_lags, int codificacion, char filename[]);
+void initialize_gates(struct Gate gates[], int cant_pulsos_archivo);
+void free_absolute_values_gates(struct Gate gates[], int cant_pulsos_archivo);
+void free_gates(struct Gate gates[], int cant_pulsos_archivo);
+void silenciar_salida(int silenciar);
+int save_time_to_file(double execution_time, int hilos, char filename[]);
+void process_arguments(int argc, char *argv[], struct Opciones* opciones);
\ No newline at end of file
@@ -0,0 +1,52 @@
+/** @file incremental.h
+ *  @brief Autocorrelacion incremental de una captura que crece.
+ *
+ *  El radar agrega pulsos al final de la captura de forma continua. Este modo
+ *  guarda, junto a la captura, las sumas sin normalizar de cada desplazamiento
+ *  de cada gate y las columnas de modulos ya calculadas, de modo que una nueva
+ *  ejecucion solo procesa los pulsos agregados desde la anterior.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <stdint.h>
+
+#define ESTADO_EXTENSION ".acf"
+/*!< Extension del archivo auxiliar donde se guarda el estado incremental. */
+#define ESTADO_MAGIC 0x46434150
+/*!< Identificador del archivo de estado ("PACF"). */
+#define ESTADO_VERSION 3
+/*!< Version del formato del archivo de estado. */
+#define ESTADO_VENTANA_CONTROL (1L << 20)
+/*!< Bytes del comienzo y del final de la parte procesada de la captura que
+cubre la suma de control del estado. */
+
+struct EstadoIncremental{
+	int num_pulsos;
+	int max_lags;
+	uint64_t offset;
+	float *columnas_v;
+	float *columnas_h;
+	double *sumas_v;
+	double *sumas_h;
+};
+/*!< Estado de la autocorrelacion incremental. offset es el numero de bytes de
+la captura ya procesados, que corresponden a num_pulsos pulsos. max_lags es
+la opcion -l (L+1), o 0 si se calculan todos los desplazamientos.
+Las sumas tienen lags_calculados(num_pulsos, max_lags) elementos por gate;
+sumas_v[i] es la suma de los productos del desplazamiento i, antes de dividir
+por el numero de pulsos. Las columnas guardan solo la cola de cada gate que
+hace falta para extenderlo, cola_estado() elementos por gate. */
+
+int cola_estado(int num_pulsos, int max_lags);
+void cargar_estado(char file_name[], int max_lags, struct EstadoIncremental *estado);
+int guardar_estado(char file_name[], const struct EstadoIncremental *estado, const struct Gate gates[]);
+void liberar_estado(struct EstadoIncremental *estado);
+int contar_pulsos_nuevos(char file_name[], uint64_t offset, int *num_nuevos, uint64_t *fin);
+void restaurar_columnas(const struct EstadoIncremental *estado, struct Gate gates[]);
+void acumular_lags(const float columna[], int desde, int hasta, int num_lags, double suma[]);
+
+#endif
@@ -0,0 +1,34 @@
+/** @file indice.h
+ *  @brief Indice de pulsos de una captura del radar.
+ *
+ *  Tabla con el offset y el numero de muestras de cada pulso del archivo,
+ *  persistida en un archivo auxiliar para no recorrer la captura en cada
+ *  ejecucion.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef INDICE_H
+#define INDICE_H
+
+#include <stdint.h>
+
+#define INDICE_EXTENSION ".idx"
+/*!< Extension del archivo auxiliar donde se guarda el indice. */
+#define INDICE_MAGIC 0x58444950
+/*!< Identificador del archivo de indice ("PIDX"). */
+#define INDICE_VERSION 1
+/*!< Version del formato del archivo de indice. */
+
+struct IndicePulsos{
+	int num_pulsos;
+	uint64_t *offsets;
+	uint16_t *valid_samples;
+};
+/*!< Indice de una captura. offsets[i] es la posicion en bytes del encabezado
+del pulso i; su tabla de 4*valid_samples[i] floats comienza 2 bytes despues. */
+
+int obtener_indice(char file_name[], struct IndicePulsos *indice);
+void liberar_indice(struct IndicePulsos *indice);
+
+#endif
@@ -0,0 +1,32 @@
+/** @file ingesta.h
+ *  @brief Lectura asincrona de capturas completas con lecturas grandes en vuelo.
+ *
+ *  En lugar de un fread de 2 bytes y otro de una tabla por pulso, la captura
+ *  se lee en bloques de INGESTA_BLOQUE bytes alineados, con varios pedidos
+ *  en vuelo a la vez: con io_uring si el kernel lo permite, o con un grupo de
+ *  hilos que hacen pread. Si el sistema de archivos lo admite se abre con
+ *  O_DIRECT, sin pasar por la cache de paginas. Los limites de cada pulso se
+ *  buscan despues sobre el buffer leido.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef INGESTA_H
+#define INGESTA_H
+
+#include <stddef.h>
+
+#define INGESTA_BLOQUE (1 << 20)
+/*!< Bytes de cada lectura. Multiplo de INGESTA_ALINEACION. */
+#define INGESTA_EN_VUELO 8
+/*!< Lecturas pendientes a la vez, y numero de hilos del respaldo con pread. */
+#define INGESTA_ALINEACION 4096
+/*!< Alineacion de buffer, offset y largo que exige O_DIRECT. */
+#define INGESTA_FRACCION_MEMORIA 2
+/*!< La captura se lee completa a memoria solo si ocupa a lo sumo
+1/INGESTA_FRACCION_MEMORIA de la memoria fisica; si no, se mapea. */
+
+void *ingerir_archivo(char file_name[], size_t *tamano, const char **metodo);
+int entra_en_memoria(size_t tamano);
+
+#endif
@@ -0,0 +1,33 @@
+/** @file lote.h
+ *  @brief Lote de capturas a procesar en una misma ejecucion.
+ *
+ *  El modo por lotes recibe un directorio o una lista de capturas y las
+ *  procesa una tras otra, con el mismo equipo de hilos y la misma matriz de
+ *  gates, en lugar de lanzar un proceso por archivo.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef LOTE_H
+#define LOTE_H
+
+#include <stdint.h>
+
+#define LOTE_EXTENSION ".iq"
+/*!< Extension de las capturas que se toman de un directorio. */
+
+struct Lote{
+	int num_capturas;
+	char **rutas;
+	uint64_t *bytes;
+};
+/*!< Capturas de un lote, ordenadas de mayor a menor tamaño. La primera
+captura fija el tamaño de la matriz de gates, que luego se reutiliza para
+todas las demas sin volver a reservarla. */
+
+int crear_lote(char origen[], struct Lote *lote);
+void liberar_lote(struct Lote *lote);
+char *ruta_salida(const char captura[], const char sufijo[]);
+void anticipar_captura(const char captura[]);
+
+#endif
@@ -0,0 +1,51 @@
+/** @file matriz.h
+ *  @brief Arena unica para la matriz de gates.
+ *
+ *  Las cuatro columnas de todos los gates (modulos y autocorrelacion de
+ *  cada componente) se reservan juntas, en lugar de hacer 2000 mallocs. La
+ *  arena se organiza por region: primero todas las columnas absol_v, luego
+ *  absol_h, vector_autocorr_v y vector_autocorr_h. Cada columna comienza en un
+ *  limite de 64 bytes.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef MATRIZ_H
+#define MATRIZ_H
+
+#include <stddef.h>
+
+#define ALINEACION_COLUMNA 64
+/*!< Alineacion en bytes de cada columna de la matriz: una linea de cache. */
+
+#define REGION_ABSOL_V 0
+/*!< Region de la arena con las columnas absol_v. */
+#define REGION_ABSOL_H 1
+/*!< Region de la arena con las columnas absol_h. */
+#define REGION_AUTOCORR_V 2
+/*!< Region de la arena con las columnas vector_autocorr_v. */
+#define REGION_AUTOCORR_H 3
+/*!< Region de la arena con las columnas vector_autocorr_h. */
+#define NUM_REGIONES 4
+/*!< Numero de regiones de la arena. */
+
+size_t largo_columna(int num_pulsos);
+float *reservar_matriz(int num_pulsos, int hilos);
+void descartar_modulos(float *matriz, int num_pulsos);
+void liberar_matriz(float *matriz, int num_pulsos);
+
+/**
+* @brief Columna de un gate dentro de la arena.
+*
+* @param matriz Arena reservada con reservar_matriz().
+* @param num_pulsos Numero de pulsos con que se reservo la arena.
+* @param region Una de las REGION_*.
+* @param gate Numero de gate.
+* @return Puntero al primer elemento de la columna, alineado a ALINEACION_COLUMNA.
+*/
+static inline float *
+columna_gate(float *matriz, int num_pulsos, int region, int gate){
+	return matriz + ((size_t)region*radar.num_gates + gate) * largo_columna(num_pulsos);
+}
+
+#endif
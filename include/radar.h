@@ -0,0 +1,112 @@
+/** @file radar.h
+ *  @brief Definiciones comunes a las ejecuciones monothread y multithread.
+ *
+ *  Constantes, estructuras y prototipos compartidos por ambos programas y por
+ *  los modulos que se compilan en los dos binarios.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef RADAR_H
+#define RADAR_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../include/colors.h"
+
+#define MAX_DATOS_LECTURA_DEFECTO 5900
+/*!< Numero maximo de datos por pulso en el archivo a leer, salvo que se indique otro con -x. */
+#define NUM_GATES_DEFECTO 500
+/*!< Numero de gates que discrimina el radar, salvo que se indique otro con -g. */
+#define MAX_GATES 8192
+/*!< Numero maximo de gates admitido: acota las matrices de promedios por bloque, que van en el stack. */
+
+struct Radar{
+	int num_gates;
+	int max_muestras;
+};
+/*!< Configuracion del radar que se procesa: numero de gates y numero maximo de
+muestras por pulso. Se fija al leer la linea de comandos y no cambia durante
+la ejecucion. */
+
+extern struct Radar radar;
+
+#define PULSOS_POR_BLOQUE 16
+/*!< Numero de pulsos que se promedian juntos antes de volcarlos a los gates.
+Cada gate recibe una corrida contigua de PULSOS_POR_BLOQUE floats (una linea
+de cache de 64 bytes), en lugar de un float suelto por pulso. */
+
+struct Gate{
+	float *absol_v;
+	float *absol_h;
+	float *vector_autocorr_v;
+	float *vector_autocorr_h;
+};
+/*!< Estructura de un gate. Contiene valores absolutos de las componentes vertical
+y horizontal de las mediciones, de todos los pulsos, y los valores de autocorrelacion
+de los mismos.*/
+
+#define MOTOR_AUTO 0
+/*!< Motor de autocorrelacion elegido segun el tamaño del problema y la CPU. */
+#define MOTOR_DIRECTO 1
+/*!< Motor de autocorrelacion directo, O(N^2) por gate. */
+#define MOTOR_FFT 2
+/*!< Motor de autocorrelacion por FFT, O(N log N) por gate. */
+#define MOTOR_SIMD 3
+/*!< Motor de autocorrelacion directo con kernels vectorizados. */
+
+#define LECTURA_AUTO 0
+/*!< Lectura de la captura elegida segun su tamaño. */
+#define LECTURA_FREAD 1
+/*!< Lectura de la captura con fread, pulso por pulso, a un almacen. */
+#define LECTURA_MMAP 2
+/*!< Lectura de la captura mapeandola en memoria. */
+#define LECTURA_ASINCRONA 3
+/*!< Lectura de la captura completa con lecturas grandes asincronas. */
+
+#define FORMATO_V1 0
+/*!< Formato original del archivo de resultados: numero de desplazamientos en un uint16_t. */
+#define FORMATO_F32 1
+/*!< Formato versionado, con los vectores en float. */
+#define FORMATO_F16 2
+/*!< Formato versionado, con los vectores en half y una escala por vector. */
+#define FORMATO_XOR 3
+/*!< Formato versionado, con los vectores comprimidos sin perdida. */
+
+struct Opciones{
+	int time_flag;
+	int save_flag;
+	int num_threads;
+	int lectura;
+	int indice_flag;
+	int flujo_flag;
+	int pipeline_flag;
+	int incremental_flag;
+	int posicional_flag;
+	int ventana;
+	int paso;
+	double plazo;
+	int num_lags;
+	int motor;
+	int formato;
+	char *lote;
+	char *kernels;
+};
+/*!< Opciones de ejecucion recibidas por linea de comandos. */
+
+void *safe_malloc(size_t n);
+
+/**
+* @brief Numero de desplazamientos de la autocorrelacion que se calculan y guardan.
+*
+* @param num_pulsos Numero de pulsos de cada gate.
+* @param num_lags Desplazamientos pedidos con la opcion -l (L+1), o 0 para calcularlos todos.
+* @return min(num_lags, num_pulsos), o num_pulsos si num_lags es 0.
+*/
+static inline int
+lags_calculados(int num_pulsos, int num_lags){
+	return (num_lags > 0 && num_lags < num_pulsos) ? num_lags : num_pulsos;
+}
+
+#endif
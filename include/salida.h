@@ -0,0 +1,36 @@
+/** @file salida.h
+ *  @brief Escritura posicional del archivo de resultados.
+ *
+ *  Con una codificacion de tamaño fijo (todas salvo FORMATO_XOR), cada gate
+ *  ocupa en el archivo de resultados un bloque del mismo tamaño. Conocido el
+ *  numero de desplazamientos, el offset de cada gate se calcula de antemano, y cada
+ *  hilo escribe sus gates con pwritev apenas termina de calcularlos, sin
+ *  esperar al resto ni compartir un FILE*.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef SALIDA_H
+#define SALIDA_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sys/types.h>
+#include "../include/formato.h"
+
+struct Salida{
+	int fd;
+	struct Formato formato;
+	off_t inicio_gates;
+	size_t bytes_gate;
+	atomic_int error;
+};
+/*!< Archivo de resultados abierto para escritura posicional. El gate i ocupa
+bytes_gate bytes a partir de inicio_gates + i*bytes_gate. error queda en 1 si
+fallo la escritura de algun gate, desde cualquier hilo. */
+
+int abrir_salida(struct Salida *salida, char filename[], const struct Formato *formato);
+void escribir_gate_salida(struct Salida *salida, const struct Gate *gate, int indice);
+int cerrar_salida(struct Salida *salida);
+
+#endif
@@ -0,0 +1,24 @@
+/** @file simd.h
+ *  @brief Kernels vectorizados con seleccion segun la CPU.
+ *
+ *  Kernels escritos con intrinsics SSE, AVX2 y AVX-512, y su version escalar:
+ *  autocorrelacion directa y modulo de lotes de muestras I/Q.
+ *  inicializar_simd() detecta las extensiones disponibles al inicio del
+ *  programa y elige la mas ancha, o la pedida con la opcion -k.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#define LAGS_POR_PASADA 4
+/*!< Numero de desplazamientos que calculan juntos los kernels de autocorrelacion.
+Cada carga de vector[j] alimenta a LAGS_POR_PASADA acumuladores. */
+
+const char *inicializar_simd(const char preferido[]);
+int simd_vectorial(void);
+void autocorrelacion_simd(const float vector[], int len, int num_lags, float resultado[]);
+void modulos_iq(const void *iq, int n, float modulo[]);
+
+#endif
@@ -0,0 +1,36 @@
+/** @file ventana.h
+ *  @brief Autocorrelacion sobre una ventana deslizante de pulsos.
+ *
+ *  Para el modo en tiempo real: mantiene, para cada gate, los modulos de los
+ *  ultimos M pulsos recibidos y las sumas sin normalizar de cada
+ *  desplazamiento sobre esos M pulsos. Cada pulso nuevo suma su aporte y resta
+ *  el del pulso que sale de la ventana, en O(M) por gate.
+ *
+ *  @author Facundo Maero
+ */
+
+#ifndef VENTANA_H
+#define VENTANA_H
+
+struct Ventana{
+	int capacidad;
+	int num_lags;
+	long total;
+	double *sumas_v;
+	double *sumas_h;
+};
+/*!< Ventana deslizante de capacidad pulsos. total es el numero de pulsos
+recibidos hasta el momento; la ventana contiene los ultimos
+min(total, capacidad). Solo se calculan los primeros num_lags desplazamientos:
+sumas_v tiene num_lags elementos por gate. Los modulos
+se guardan en las columnas absol_v y absol_h de cada gate, usadas como buffer
+circular: el pulso n ocupa la posicion n % capacidad. */
+
+void crear_ventana(struct Ventana *ventana, int capacidad, int max_lags);
+void liberar_ventana(struct Ventana *ventana);
+void desplazar_gate(const struct Ventana *ventana, struct Gate *gate, int indice_gate, long n, float valor_v, float valor_h);
+void normalizar_gate(const struct Ventana *ventana, struct Gate *gate, int indice_gate);
+int pulsos_en_ventana(const struct Ventana *ventana);
+int lags_en_ventana(const struct Ventana *ventana);
+
+#endif
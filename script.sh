@@ -1,48 +1,6 @@
 #!/bin/bash
-for run in {1..100};
-do ./build/single_threaded -s;
-done
-
-for run in {1..100};
-do ./build/multithreaded 2 -s;
-done
-
-for run in {1..100};
-do ./build/multithreaded 3 -s;
-done
-
-for run in {1..100};
-do ./build/multithreaded 4 -s;
-done
-
-for run in {1..100};
-do ./build/multithreaded 5 -s;
-done
-
-for run in {1..100};
-do ./build/multithreaded 6 -s;
-done
-
-for run in {1..100};
-do ./build/multithreaded 7 -s;
-done
-
-for run in {1..100};
-do ./build/multithreaded 8 -s;
-done
-
-for run in {1..100};
-do ./build/multithreaded 16 -s;
-done
-
-for run in {1..100};
-do ./build/multithreaded 32 -s;
-done
-
-for run in {1..100};
-do ./build/multithreaded 64 -s;
-done
-
-for run in {1..100};
-do ./build/multithreaded 128 -s;
-done
\ No newline at end of file
+# Mide el procesamiento de pulsos.iq con 1 a 128 hilos, 100 iteraciones por
+# numero de hilos, y guarda los tiempos de cada etapa en un JSON con la fecha
+# de la medicion. Los argumentos se pasan a build/benchmark (por ejemplo -a fft).
+make -s benchmark || exit 1
+./build/benchmark -n 100 -w 5 -h 1,2,3,4,5,6,7,8,16,32,64,128 -j "benchmark_$(date +%Y%m%d_%H%M%S).json" "$@"
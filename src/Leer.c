@@ -23,15 +23,40 @@
 * 	"make"					--> Compila el proyecto y genera ejecutable.
 * 	"make clean"			--> Limpia para una nueva compilación.
 * 	"make cppcheck" 		--> Ejecuta el programa CppCheck sobre el proyecto. (Debe estar instalado).
+* 	"./radar"				--> Ejecuta el programa con todos los hilos disponibles.
 * 	"./single_threaded"		--> Ejecuta el programa en su versión single threaded.
 * 	"./multithreaded"		--> Ejecuta el programa en su versión multithreaded.
+* 	"make benchmark"		--> Compila el programa de medicion por etapas, "./benchmark".
+* 	"make micro"			--> Compila los microbenchmarks de cada kernel con modelo roofline, "./micro".
+* 	"make generador"		--> Compila el generador de capturas sinteticas, "./generador".
+* 	"make comparar"			--> Compila el comparador de resultados con tolerancia y de mediciones, "./comparar".
+* 	"make CONTADORES=1"		--> Compila con contadores de hardware (perf_event_open) por etapa e hilo.
 *
 * @par EJECUCIÓN:
+* Ambas versiones son un unico binario, "radar"; "single_threaded" y "multithreaded" son\n
+* enlaces a el, y el nombre solo cambia el numero de hilos por defecto y los archivos de salida.\n
 * Para ejecutar el programa monothread, utilizar el comando "./single_threaded".\n
 * Para ejecutar el programa ejecutado en paralelo, utilizar el comando "./multithreaded".\n
 * Opciones que aceptan los binarios: \n
 * --> -t Muestra por la salida standard el tiempo de ejecución del código.\n
 * --> -s Guarda en un archivo de texto el tiempo de ejecución del código.\n
+* --> -m Lee el archivo de pulsos mapeandolo en memoria (sin copias por pulso).\n
+* --> -u Lee la captura completa con lecturas grandes asincronas (io_uring, o pread en paralelo) y O_DIRECT si es posible.\n
+* --> -i Usa el indice de pulsos guardado en "pulsos.iq.idx", o lo construye.\n
+* --> -f Procesa los pulsos en flujo: la memoria depende solo de la matriz de gates.\n
+* --> -p (Solo multihilo) Un hilo lee los pulsos mientras los demas calculan sus promedios.\n
+* --> -c Modo incremental: guarda el estado de la autocorrelacion y procesa solo los pulsos nuevos.\n
+* --> -w <M> <K> Tiempo real: lee los pulsos de la entrada estandar y emite la autocorrelacion de los ultimos M cada K pulsos.\n
+* --> -d <ms> Con -w, latencia maxima admitida por bloque; se avisa cada bloque que la supera y se termina con error.\n
+* --> -o Escribe cada gate en su lugar del archivo de resultados apenas se calcula (pwritev desde cada hilo).\n
+* --> -g <gates> Numero de gates del radar (por defecto 500).\n
+* --> -x <muestras> Numero maximo de muestras por pulso (por defecto 5900).\n
+* --> -l <L> Calcula y guarda solo los desplazamientos 0 a L de la autocorrelacion.\n
+* --> -b <lote> Procesa todas las capturas de un directorio (archivos .iq) o de una lista, con un archivo de resultados por captura.\n
+* --> -e <formato> Formato del archivo de resultados: "v1" (original, por defecto), "f32", "f16" o "xor".\n
+* --> -a <motor> Elige el motor de autocorrelacion: "auto" (por defecto, segun el tamaño del problema), "directo", "fft" o "simd".\n
+* --> -r <lectura> Elige la lectura de la captura: "auto" (por defecto), "fread", "mmap" o "asincrona".\n
+* --> -k <kernels> Fuerza los kernels vectoriales: "avx512", "avx2", "sse" o "escalar".\n
 * --> <numero_de_hilos> En el caso del programa distribuído, lo ejecuta con el número de hilos ingresado.\n
 * En el informe del trabajo se incluyen gráficos y estadísticas obtenidas de la ejecución \n
 * del software en la notebook del alumno, y el clúster de la Facultad.\n
@@ -0,0 +1,72 @@
+/** @file almacen.c
+ *  @brief Almacen compacto de pulsos.
+ *
+ *  Reemplaza al arreglo de struct Pulso, que reservaba MAX_DATOS_LECTURA
+ *  lecturas por pulso sin importar cuantas tuviera realmente. Las tablas se
+ *  guardan crudas, sin separar las componentes: los modulos se calculan
+ *  directamente sobre los pares I/Q intercalados.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/radar.h"
+#include "../include/almacen.h"
+
+/**
+* @brief Reserva un almacen para un numero de pulsos y de muestras conocido.
+*
+* El numero total de floats se conoce sin leer las tablas: es el tamaño del
+* archivo menos los encabezados de los pulsos, o la suma de 4*valid_samples
+* del indice.
+*
+* @param almacen Almacen a inicializar.
+* @param num_pulsos Numero de pulsos a guardar.
+* @param num_floats Numero total de floats de las tablas de todos los pulsos.
+*/
+void
+crear_almacen(struct AlmacenPulsos *almacen, int num_pulsos, size_t num_floats){
+	almacen->num_pulsos = num_pulsos;
+	almacen->capacidad = num_floats;
+	almacen->arena = safe_malloc(sizeof(float) * (num_floats > 0 ? num_floats : 1));
+	almacen->offsets = safe_malloc(sizeof(size_t) * (num_pulsos + 1));
+	almacen->valid_samples = safe_malloc(sizeof(int) * (num_pulsos > 0 ? num_pulsos : 1));
+	almacen->offsets[0] = 0;
+}
+
+/**
+* @brief Libera la memoria de un almacen.
+*
+* @param almacen Almacen creado con crear_almacen().
+*/
+void
+liberar_almacen(struct AlmacenPulsos *almacen){
+	free(almacen->arena);
+	free(almacen->offsets);
+	free(almacen->valid_samples);
+	almacen->arena = NULL;
+	almacen->offsets = NULL;
+	almacen->valid_samples = NULL;
+}
+
+/**
+* @brief Reserva el lugar de un pulso en la arena.
+*
+* Debe llamarse en orden, pulso por pulso, ya que el offset de cada pulso se
+* calcula a partir del anterior. Una vez ubicados, los pulsos pueden
+* leerse en cualquier orden, incluso en paralelo.
+*
+* @param almacen Almacen de pulsos.
+* @param pulso Numero de pulso.
+* @param valid_samples Numero de muestras del pulso.
+* @return 1 si el pulso no entra en la arena, 0 caso contrario.
+*/
+int
+ubicar_pulso(struct AlmacenPulsos *almacen, int pulso, int valid_samples){
+	if(pulso >= almacen->num_pulsos
+		|| almacen->offsets[pulso] + 4*(size_t)valid_samples > almacen->capacidad){
+		return 1;
+	}
+	almacen->valid_samples[pulso] = valid_samples;
+	almacen->offsets[pulso+1] = almacen->offsets[pulso] + 4*(size_t)valid_samples;
+	return 0;
+}
+
@@ -0,0 +1,169 @@
+/** @file anillo.c
+ *  @brief Buffer circular acotado y sin locks entre el lector y los hilos de calculo.
+ *
+ *  La celda de la posicion pos esta libre para el productor cuando su
+ *  secuencia vale pos, y lista para un consumidor cuando vale pos+1. Al
+ *  devolverla, el consumidor la deja en pos+capacidad: libre para la
+ *  siguiente vuelta del anillo.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/radar.h"
+#include "../include/anillo.h"
+#include <sched.h>
+
+/**
+* @brief Crea un anillo con ANILLO_CELDAS_POR_HILO celdas por consumidor.
+*
+* La capacidad se redondea a la siguiente potencia de 2, para ubicar cada
+* posicion con una mascara. Cada celda reserva espacio para PULSOS_POR_BLOQUE
+* tablas de radar.max_muestras muestras.
+*
+* @param anillo Anillo a inicializar.
+* @param consumidores Numero de hilos que toman celdas del anillo.
+*/
+void
+crear_anillo(struct Anillo *anillo, int consumidores){
+	size_t capacidad = 2;
+	while(capacidad < (size_t)ANILLO_CELDAS_POR_HILO * (consumidores > 0 ? consumidores : 1)){
+		capacidad *= 2;
+	}
+
+	anillo->capacidad = capacidad;
+	anillo->celdas = safe_malloc(sizeof(struct CeldaAnillo) * capacidad);
+	for (size_t i = 0; i < capacidad; ++i)
+	{
+		atomic_init(&anillo->celdas[i].secuencia, i);
+		anillo->celdas[i].crudo = safe_malloc(sizeof(float) * 4*radar.max_muestras * PULSOS_POR_BLOQUE);
+	}
+	atomic_init(&anillo->escritura, 0);
+	atomic_init(&anillo->lectura, 0);
+	atomic_init(&anillo->cancelado, 0);
+}
+
+/**
+* @brief Libera las celdas de un anillo.
+*
+* @param anillo Anillo creado con crear_anillo(), sin hilos usandolo.
+*/
+void
+liberar_anillo(struct Anillo *anillo){
+	for (size_t i = 0; i < anillo->capacidad; ++i)
+	{
+		free(anillo->celdas[i].crudo);
+	}
+	free(anillo->celdas);
+	anillo->celdas = NULL;
+}
+
+/**
+* @brief Reserva la proxima celda libre para que el productor la llene.
+*
+* Si el anillo esta lleno, espera a que un consumidor devuelva una celda,
+* cediendo el procesador en cada intento.
+*
+* @param anillo Anillo de celdas.
+* @return Celda a llenar y publicar con publicar_celda(), o NULL si el anillo fue cancelado.
+*/
+struct CeldaAnillo *
+reservar_celda(struct Anillo *anillo){
+	size_t pos = atomic_load_explicit(&anillo->escritura, memory_order_relaxed);
+
+	while(!atomic_load_explicit(&anillo->cancelado, memory_order_relaxed)){
+		struct CeldaAnillo *celda = &anillo->celdas[pos & (anillo->capacidad - 1)];
+		size_t secuencia = atomic_load_explicit(&celda->secuencia, memory_order_acquire);
+		ptrdiff_t diferencia = (ptrdiff_t)(secuencia - pos);
+
+		if(diferencia == 0){
+			if(atomic_compare_exchange_weak_explicit(&anillo->escritura, &pos, pos + 1,
+				memory_order_relaxed, memory_order_relaxed)){
+				celda->posicion = pos;
+				return celda;
+			}
+			//pos ya tiene el valor actualizado por otro productor
+		}
+		else if(diferencia < 0){
+			sched_yield();
+			//lleno: la celda todavia tiene datos de la vuelta anterior
+			pos = atomic_load_explicit(&anillo->escritura, memory_order_relaxed);
+		}
+		else{
+			pos = atomic_load_explicit(&anillo->escritura, memory_order_relaxed);
+		}
+	}
+	return NULL;
+}
+
+/**
+* @brief Marca una celda llena como lista para los consumidores.
+*
+* @param anillo Anillo de celdas.
+* @param celda Celda obtenida con reservar_celda().
+*/
+void
+publicar_celda(struct Anillo *anillo, struct CeldaAnillo *celda){
+	atomic_store_explicit(&celda->secuencia, celda->posicion + 1, memory_order_release);
+}
+
+/**
+* @brief Toma la proxima celda lista para procesar.
+*
+* Si el anillo esta vacio, espera a que el productor publique una celda,
+* cediendo el procesador en cada intento. Como el numero total de celdas a
+* producir se conoce de antemano, un consumidor termina al llegar a total,
+* sin que el productor tenga que avisarle.
+*
+* @param anillo Anillo de celdas.
+* @param total Numero de celdas que producira el productor en total.
+* @return Celda a procesar y devolver con devolver_celda(), o NULL si ya se
+* tomaron todas o el anillo fue cancelado.
+*/
+struct CeldaAnillo *
+tomar_celda(struct Anillo *anillo, size_t total){
+	size_t pos = atomic_load_explicit(&anillo->lectura, memory_order_relaxed);
+
+	while(pos < total && !atomic_load_explicit(&anillo->cancelado, memory_order_relaxed)){
+		struct CeldaAnillo *celda = &anillo->celdas[pos & (anillo->capacidad - 1)];
+		size_t secuencia = atomic_load_explicit(&celda->secuencia, memory_order_acquire);
+		ptrdiff_t diferencia = (ptrdiff_t)(secuencia - (pos + 1));
+
+		if(diferencia == 0){
+			if(atomic_compare_exchange_weak_explicit(&anillo->lectura, &pos, pos + 1,
+				memory_order_relaxed, memory_order_relaxed)){
+				return celda;
+			}
+		}
+		else if(diferencia < 0){
+			sched_yield();
+			//vacio: el productor todavia no publico esta celda
+			pos = atomic_load_explicit(&anillo->lectura, memory_order_relaxed);
+		}
+		else{
+			pos = atomic_load_explicit(&anillo->lectura, memory_order_relaxed);
+		}
+	}
+	return NULL;
+}
+
+/**
+* @brief Devuelve al productor una celda ya procesada.
+*
+* @param anillo Anillo de celdas.
+* @param celda Celda obtenida con tomar_celda().
+*/
+void
+devolver_celda(struct Anillo *anillo, struct CeldaAnillo *celda){
+	atomic_store_explicit(&celda->secuencia, celda->posicion + anillo->capacidad, memory_order_release);
+}
+
+/**
+* @brief Cancela el anillo, por ejemplo ante un error de lectura.
+*
+* Los hilos que esperan en reservar_celda() o tomar_celda() retornan NULL.
+*
+* @param anillo Anillo de celdas.
+*/
+void
+cancelar_anillo(struct Anillo *anillo){
+	atomic_store_explicit(&anillo->cancelado, 1, memory_order_relaxed);
+}
@@ -0,0 +1,179 @@
+/** @file backend.c
+ *  @brief Registro y eleccion de backends del calculo.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/radar.h"
+#include "../include/backend.h"
+#include "../include/simd.h"
+#include <string.h>
+#include <sys/stat.h>
+
+static const struct EntradaBackend registro_motores[] = {
+	{"auto", MOTOR_AUTO},
+	{"directo", MOTOR_DIRECTO},
+	{"fft", MOTOR_FFT},
+	{"simd", MOTOR_SIMD},
+	{NULL, 0}
+};
+/*!< Motores de autocorrelacion, para la opcion -a. */
+
+static const struct EntradaBackend registro_lecturas[] = {
+	{"auto", LECTURA_AUTO},
+	{"fread", LECTURA_FREAD},
+	{"mmap", LECTURA_MMAP},
+	{"asincrona", LECTURA_ASINCRONA},
+	{NULL, 0}
+};
+/*!< Metodos de lectura de la captura, para la opcion -r. */
+
+/**
+* @brief Busca una entrada de un registro por su nombre.
+*
+* @param registro[] Registro terminado en una entrada con nombre NULL.
+* @param nombre[] Nombre a buscar.
+* @return Valor de la entrada, o -1 si no existe.
+*/
+static int
+buscar_valor(const struct EntradaBackend registro[], const char nombre[]){
+	for (int i = 0; registro[i].nombre != NULL; ++i)
+	{
+		if(strcmp(registro[i].nombre, nombre) == 0){
+			return registro[i].valor;
+		}
+	}
+	return -1;
+}
+
+/**
+* @brief Busca el nombre de una entrada de un registro por su valor.
+*
+* @param registro[] Registro terminado en una entrada con nombre NULL.
+* @param valor Valor a buscar.
+* @return Nombre de la entrada, o "?" si no existe.
+*/
+static const char *
+buscar_nombre(const struct EntradaBackend registro[], int valor){
+	for (int i = 0; registro[i].nombre != NULL; ++i)
+	{
+		if(registro[i].valor == valor){
+			return registro[i].nombre;
+		}
+	}
+	return "?";
+}
+
+/**
+* @brief Traduce el nombre de un motor de autocorrelacion.
+*
+* @param nombre[] "auto", "directo", "fft" o "simd".
+* @return Uno de los MOTOR_*, o -1 si no se reconoce.
+*/
+int
+motor_por_nombre(const char nombre[]){
+	return buscar_valor(registro_motores, nombre);
+}
+
+/**
+* @brief Nombre de un motor de autocorrelacion.
+*
+* @param motor Uno de los MOTOR_*.
+* @return Nombre del motor.
+*/
+const char *
+nombre_motor(int motor){
+	return buscar_nombre(registro_motores, motor);
+}
+
+/**
+* @brief Traduce el nombre de un metodo de lectura.
+*
+* @param nombre[] "auto", "fread", "mmap" o "asincrona".
+* @return Uno de los LECTURA_*, o -1 si no se reconoce.
+*/
+int
+lectura_por_nombre(const char nombre[]){
+	return buscar_valor(registro_lecturas, nombre);
+}
+
+/**
+* @brief Nombre de un metodo de lectura.
+*
+* @param lectura Uno de los LECTURA_*.
+* @return Nombre del metodo.
+*/
+const char *
+nombre_lectura(int lectura){
+	return buscar_nombre(registro_lecturas, lectura);
+}
+
+/**
+* @brief Nombre del backend de ejecucion para un numero de hilos.
+*
+* Con un hilo, las regiones paralelas se ejecutan directamente en el hilo
+* principal, sin repartir trabajo.
+*
+* @param hilos Numero de hilos de OpenMP.
+* @return "escalar" con un hilo, "openmp" con mas.
+*/
+const char *
+nombre_ejecucion(int hilos){
+	return hilos > 1 ? "openmp" : "escalar";
+}
+
+/**
+* @brief Elige el motor de autocorrelacion para un problema.
+*
+* El motor directo (o simd) hace del orden de N*L operaciones por gate, y la
+* FFT del orden de M*log2(M), con M la potencia de 2 mayor o igual a N+L,
+* pero con una constante mayor. Se elige la FFT cuando la primera cuenta
+* supera a la segunda por el factor medido para los kernels disponibles.
+*
+* @param motor Motor pedido con la opcion -a.
+* @param num_pulsos Numero de pulsos de cada gate.
+* @param num_lags Numero de desplazamientos a calcular.
+* @return El motor pedido, o si es MOTOR_AUTO, el elegido.
+*/
+int
+elegir_motor(int motor, int num_pulsos, int num_lags){
+	if(motor != MOTOR_AUTO){
+		return motor;
+	}
+	double largo = 1, bits = 0;
+	while(largo < (double)num_pulsos + num_lags){
+		largo *= 2;
+		bits++;
+	}
+	double directo = (double)num_pulsos * num_lags;
+	double fft = largo * (bits > 0 ? bits : 1);
+
+	if(simd_vectorial()){
+		return directo > FFT_FACTOR_SIMD * fft ? MOTOR_FFT : MOTOR_SIMD;
+	}
+	return directo > FFT_FACTOR_ESCALAR * fft ? MOTOR_FFT : MOTOR_DIRECTO;
+}
+
+/**
+* @brief Elige el metodo de lectura de una captura.
+*
+* La captura se mapea en memoria, sin importar su tamaño: las paginas se
+* traen a demanda y el kernel puede descartarlas, mientras que la lectura
+* asincrona necesita tanta memoria como la captura, por lo que solo se usa si
+* se la pide. Si no se puede consultar el archivo se usa fread, que informara
+* el error al leerlo.
+*
+* @param lectura Metodo pedido con -r, -m o -u.
+* @param file_name[] Nombre de la captura.
+* @return El metodo pedido, o si es LECTURA_AUTO, el elegido.
+*/
+int
+elegir_lectura(int lectura, char file_name[]){
+	struct stat st;
+	if(lectura != LECTURA_AUTO){
+		return lectura;
+	}
+	if(stat(file_name, &st) != 0){
+		return LECTURA_FREAD;
+	}
+	return LECTURA_MMAP;
+}
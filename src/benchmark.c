@@ -0,0 +1,548 @@
+/** @file benchmark.c
+ *  @brief Programa de medicion del motor, etapa por etapa.
+ *
+ *  Ejecuta el mismo procesamiento que build/radar sobre una captura, varias
+ *  veces y dentro del mismo proceso, para cada numero de hilos pedido. Cada
+ *  iteracion mide por separado el tiempo real (omp_get_wtime) del conteo de
+ *  pulsos, la lectura, el calculo de modulos y promedios, la autocorrelacion
+ *  y la escritura del archivo de resultados. Las primeras iteraciones de cada
+ *  corrida calientan las caches y el allocator y no se registran.
+ *
+ *  El resultado se guarda en JSON: la mediana, el percentil 95 y el 99 de cada
+ *  etapa, el caudal en pulsos y muestras por segundo, y la aceleracion y la
+ *  eficiencia de cada numero de hilos respecto del primero.
+ *
+ *  Los resultados de cada iteracion se escriben en el archivo de -o, o si no
+ *  se indica, en un archivo temporal que se borra al terminar.
+ *
+ *  @author Facundo Maero
+ */
+
+#include "../include/func_radar.h"
+#include <unistd.h>
+
+#define ETAPA_CONTEO 0
+/*!< Conteo de pulsos de la captura. Con mmap o lectura asincrona se hace al abrirla, dentro de la lectura. */
+#define ETAPA_LECTURA 1
+/*!< Lectura de las muestras de la captura. */
+#define ETAPA_MODULO 2
+/*!< Calculo de los modulos y promedios por gate, incluida la reserva de la matriz de gates. */
+#define ETAPA_AUTOCORRELACION 3
+/*!< Calculo de la autocorrelacion de todos los gates. */
+#define ETAPA_ESCRITURA 4
+/*!< Escritura del archivo de resultados. */
+#define NUM_ETAPAS 5
+/*!< Numero de etapas medidas. Se mide ademas el total de cada iteracion. */
+#define MAX_CORRIDAS 32
+/*!< Numero maximo de valores de hilos que se miden en una ejecucion. */
+#define ITERACIONES_DEFECTO 10
+/*!< Iteraciones registradas por corrida, salvo que se indique otro numero con -n. */
+#define CALENTAMIENTO_DEFECTO 2
+/*!< Iteraciones de calentamiento por corrida, salvo que se indique otro numero con -w. */
+
+static const char *nombres_etapas[NUM_ETAPAS + 1] = {
+	"conteo", "lectura", "modulo", "autocorrelacion", "escritura", "total"
+};
+
+struct OpcionesBenchmark{
+	char *captura;
+	char *json;
+	char *salida;
+	char *kernels;
+	int iteraciones;
+	int calentamiento;
+	int hilos[MAX_CORRIDAS];
+	int num_corridas;
+	int lectura;
+	int motor;
+	int num_lags;
+	int formato;
+};
+/*!< Opciones del programa de medicion recibidas por linea de comandos. */
+
+struct Estadistica{
+	double mediana;
+	double p95;
+	double p99;
+};
+/*!< Resumen de los tiempos de una etapa a lo largo de las iteraciones de una corrida. */
+
+struct Corrida{
+	int hilos;
+	struct Estadistica etapas[NUM_ETAPAS + 1];
+};
+/*!< Resultado de las iteraciones con un numero de hilos. */
+
+struct Problema{
+	int num_pulsos;
+	long num_muestras;
+	int num_lags;
+	int motor;
+};
+/*!< Tamaño de la captura medida y motor de autocorrelacion usado. */
+
+/**
+* @brief Devuelve el tiempo transcurrido desde la marca anterior y la actualiza.
+*
+* @param marca Marca de tiempo, en segundos.
+* @return Segundos transcurridos.
+*/
+static double
+vuelta(double *marca){
+	double ahora = omp_get_wtime();
+	double transcurrido = ahora - *marca;
+	*marca = ahora;
+	return transcurrido;
+}
+
+/**
+* @brief Ejecuta una vez el procesamiento completo de la captura y mide cada etapa.
+*
+* Con lectura fread los pulsos se cuentan en una pasada y luego se leen a un
+* almacen; con mmap o lectura asincrona, el conteo es parte de abrir la captura
+* y la etapa de conteo queda en 0. El motor AUTO se resuelve aqui, ya con el
+* numero de pulsos, para no informarlo en cada iteracion.
+*
+* @param opciones Opciones del programa, con la lectura ya resuelta.
+* @param gates[] Arreglo de radar.num_gates gates, sin inicializar.
+* @param tiempos[] Tiempos de cada etapa y el total, en segundos.
+* @param problema Tamaño de la captura y motor usado.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+static int
+medir_iteracion(const struct OpcionesBenchmark *opciones, struct Gate gates[], double tiempos[], struct Problema *problema){
+	double inicio = omp_get_wtime();
+	double marca = inicio;
+	uint64_t tamano_archivo_bytes;
+	int en_memoria = opciones->lectura == LECTURA_MMAP || opciones->lectura == LECTURA_ASINCRONA;
+	struct Captura captura;
+	struct AlmacenPulsos almacen;
+
+	if(en_memoria){
+		tiempos[ETAPA_CONTEO] = 0;
+		int error = opciones->lectura == LECTURA_ASINCRONA ?
+			cargar_captura(opciones->captura, NULL, &captura) :
+			abrir_captura(opciones->captura, NULL, &captura);
+		if(error != 0){
+			return 1;
+		}
+		problema->num_pulsos = captura.num_pulsos;
+	}
+	else{
+		if(leer_numero_pulsos_archivo(opciones->captura, &problema->num_pulsos, &tamano_archivo_bytes) != 0){
+			return 1;
+		}
+		tiempos[ETAPA_CONTEO] = vuelta(&marca);
+		if(leer_archivo(opciones->captura, &almacen, problema->num_pulsos, tamano_archivo_bytes) != 0){
+			return 1;
+		}
+	}
+	tiempos[ETAPA_LECTURA] = vuelta(&marca);
+
+	initialize_gates(gates, problema->num_pulsos);
+	problema->num_muestras = 0;
+	if(en_memoria){
+		promedio_y_valor_absoluto_captura(&captura, gates);
+		for (int i = 0; i < captura.num_pulsos; ++i)
+		{
+			problema->num_muestras += captura.pulsos[i].valid_samples;
+		}
+		cerrar_captura(&captura);
+	}
+	else{
+		promedio_y_valor_absoluto(&almacen, gates);
+		for (int i = 0; i < almacen.num_pulsos; ++i)
+		{
+			problema->num_muestras += almacen.valid_samples[i];
+		}
+		liberar_almacen(&almacen);
+	}
+	tiempos[ETAPA_MODULO] = vuelta(&marca);
+
+	problema->num_lags = lags_calculados(problema->num_pulsos, opciones->num_lags);
+	problema->motor = elegir_motor(opciones->motor, problema->num_pulsos, problema->num_lags);
+	calcular_autocorrelacion_motor(gates, problema->motor, problema->num_pulsos, problema->num_lags, NULL);
+	free_absolute_values_gates(gates, problema->num_pulsos);
+	tiempos[ETAPA_AUTOCORRELACION] = vuelta(&marca);
+
+	struct Formato formato;
+	preparar_formato(&formato, opciones->formato, problema->num_pulsos, problema->num_lags);
+	int error_guardado = guardar_archivo(gates, opciones->salida, &formato);
+	free_gates(gates, problema->num_pulsos);
+	tiempos[ETAPA_ESCRITURA] = vuelta(&marca);
+
+	tiempos[NUM_ETAPAS] = marca - inicio;
+	return error_guardado;
+}
+
+/**
+* @brief Compara dos doubles, para qsort.
+*/
+static int
+comparar_tiempos(const void *a, const void *b){
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+/**
+* @brief Resume los tiempos de una etapa: mediana y percentiles 95 y 99.
+*
+* Los percentiles se toman por rango (el menor valor que deja por debajo al
+* menos esa fraccion de las iteraciones), por lo que con pocas iteraciones
+* coinciden con el maximo.
+*
+* @param tiempos[] Tiempos de la etapa en cada iteracion. Se ordena.
+* @param n Numero de iteraciones.
+* @return Resumen de la etapa.
+*/
+static struct Estadistica
+resumir(double tiempos[], int n){
+	struct Estadistica estadistica;
+	qsort(tiempos, n, sizeof(double), comparar_tiempos);
+	estadistica.mediana = n % 2 ? tiempos[n/2] : (tiempos[n/2 - 1] + tiempos[n/2]) / 2;
+	estadistica.p95 = tiempos[(95*n + 99) / 100 - 1];
+	estadistica.p99 = tiempos[(99*n + 99) / 100 - 1];
+	return estadistica;
+}
+
+/**
+* @brief Mide el procesamiento de la captura con un numero de hilos.
+*
+* @param opciones Opciones del programa.
+* @param gates[] Arreglo de radar.num_gates gates.
+* @param hilos Numero de hilos.
+* @param corrida Resultado de la corrida.
+* @param problema Tamaño de la captura y motor usado.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+static int
+medir_corrida(const struct OpcionesBenchmark *opciones, struct Gate gates[], int hilos, struct Corrida *corrida, struct Problema *problema){
+	double *tiempos = safe_malloc(sizeof(double) * (NUM_ETAPAS + 1) * opciones->iteraciones);
+	double iteracion[NUM_ETAPAS + 1];
+	int error = 0;
+
+	omp_set_num_threads(hilos);
+	corrida->hilos = hilos;
+	silenciar_salida(1);
+	for (int i = 0; i < opciones->calentamiento + opciones->iteraciones && !error; ++i)
+	{
+		error = medir_iteracion(opciones, gates, iteracion, problema);
+		if(i >= opciones->calentamiento){
+			for (int e = 0; e <= NUM_ETAPAS; ++e)
+			{
+				tiempos[e * opciones->iteraciones + i - opciones->calentamiento] = iteracion[e];
+			}
+		}
+	}
+	silenciar_salida(0);
+
+	for (int e = 0; e <= NUM_ETAPAS && !error; ++e)
+	{
+		corrida->etapas[e] = resumir(tiempos + e * opciones->iteraciones, opciones->iteraciones);
+	}
+	free(tiempos);
+	return error;
+}
+
+/**
+* @brief Escribe una cadena JSON entre comillas, con sus caracteres especiales escapados.
+*
+* @param f Archivo de salida.
+* @param cadena Cadena a escribir (por ejemplo, una ruta).
+*/
+static void
+escribir_cadena_json(FILE *f, const char *cadena){
+	fputc('"', f);
+	for (const unsigned char *c = (const unsigned char *)cadena; *c != '\0'; ++c)
+	{
+		if(*c == '"' || *c == '\\'){
+			fprintf(f, "\\%c", *c);
+		}
+		else if(*c < 0x20){
+			fprintf(f, "\\u%04x", *c);
+		}
+		else{
+			fputc(*c, f);
+		}
+	}
+	fputc('"', f);
+}
+
+/**
+* @brief Guarda el resultado de todas las corridas en JSON.
+*
+* @param filename[] Nombre del archivo.
+* @param opciones Opciones del programa.
+* @param problema Tamaño de la captura y motor usado.
+* @param corridas[] Resultado de cada corrida.
+* @param kernels[] Nombre de los kernels SIMD usados.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+static int
+guardar_json(char filename[], const struct OpcionesBenchmark *opciones, const struct Problema *problema,
+	const struct Corrida corridas[], const char kernels[]){
+	FILE *f = fopen(filename, "w");
+	if(!f){
+		printf(BOLDRED"Error abriendo archivo para escritura\n"RESET);
+		return 1;
+	}
+	const char *formatos[] = {"v1", "f32", "f16", "xor"};
+	const struct Estadistica *base = &corridas[0].etapas[NUM_ETAPAS];
+
+	fprintf(f, "{\n");
+	fprintf(f, "  \"captura\": ");
+	escribir_cadena_json(f, opciones->captura);
+	fprintf(f, ",\n");
+	fprintf(f, "  \"num_pulsos\": %d,\n  \"num_muestras\": %ld,\n", problema->num_pulsos, problema->num_muestras);
+	fprintf(f, "  \"num_gates\": %d,\n  \"num_lags\": %d,\n", radar.num_gates, problema->num_lags);
+	fprintf(f, "  \"motor\": \"%s\",\n  \"lectura\": \"%s\",\n  \"kernels\": \"%s\",\n  \"formato\": \"%s\",\n",
+		nombre_motor(problema->motor), nombre_lectura(opciones->lectura), kernels, formatos[opciones->formato]);
+	fprintf(f, "  \"iteraciones\": %d,\n  \"calentamiento\": %d,\n", opciones->iteraciones, opciones->calentamiento);
+	fprintf(f, "  \"corridas\": [\n");
+	for (int c = 0; c < opciones->num_corridas; ++c)
+	{
+		const struct Estadistica *total = &corridas[c].etapas[NUM_ETAPAS];
+		double aceleracion = base->mediana / total->mediana;
+		fprintf(f, "    {\n      \"hilos\": %d,\n      \"ejecucion\": \"%s\",\n      \"etapas\": {\n",
+			corridas[c].hilos, nombre_ejecucion(corridas[c].hilos));
+		for (int e = 0; e <= NUM_ETAPAS; ++e)
+		{
+			fprintf(f, "        \"%s\": {\"mediana\": %.9f, \"p95\": %.9f, \"p99\": %.9f}%s\n", nombres_etapas[e],
+				corridas[c].etapas[e].mediana, corridas[c].etapas[e].p95, corridas[c].etapas[e].p99,
+				e < NUM_ETAPAS ? "," : "");
+		}
+		fprintf(f, "      },\n");
+		fprintf(f, "      \"pulsos_por_segundo\": %.3f,\n", problema->num_pulsos / total->mediana);
+		fprintf(f, "      \"muestras_por_segundo\": %.3f,\n", problema->num_muestras / total->mediana);
+		fprintf(f, "      \"aceleracion\": %.4f,\n", aceleracion);
+		fprintf(f, "      \"eficiencia\": %.4f\n", aceleracion * corridas[0].hilos / corridas[c].hilos);
+		fprintf(f, "    }%s\n", c < opciones->num_corridas - 1 ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+
+	int error = ferror(f);
+	if(fclose(f) != 0){
+		error = 1;
+	}
+	return error;
+}
+
+/**
+* @brief Interpreta una lista de numeros de hilos separados por comas.
+*
+* @param lista[] Lista, por ejemplo "1,2,4,8".
+* @param opciones Opciones donde se guardan los numeros de hilos.
+* @return 1 si algun valor es invalido, 0 caso contrario.
+*/
+static int
+leer_lista_hilos(const char lista[], struct OpcionesBenchmark *opciones){
+	char *copia = strdup(lista);
+	char *resto = NULL;
+	int error = 0;
+	opciones->num_corridas = 0;
+	for (char *valor = strtok_r(copia, ",", &resto); valor != NULL; valor = strtok_r(NULL, ",", &resto))
+	{
+		int hilos = atoi(valor);
+		if(hilos <= 0 || hilos >= MAX_NUM_THREADS || opciones->num_corridas == MAX_CORRIDAS){
+			error = 1;
+			break;
+		}
+		opciones->hilos[opciones->num_corridas++] = hilos;
+	}
+	free(copia);
+	return error || opciones->num_corridas == 0;
+}
+
+/**
+* @brief Procesa los argumentos del programa de medicion.
+*
+* Los valores aceptados son:
+* * -n <iteraciones> Iteraciones registradas por corrida (10 por defecto).
+* * -w <iteraciones> Iteraciones de calentamiento por corrida (2 por defecto).
+* * -h <hilos> Lista de numeros de hilos separados por comas. Por defecto
+* 	1 y las potencias de dos hasta el numero de hilos disponibles, y este.
+* * -j <archivo> Archivo JSON de resultados ("benchmark.json" por defecto).
+* * -o <archivo> Archivo donde escribir los resultados de cada iteracion. Por
+* 	defecto, un archivo temporal en $TMPDIR (o /tmp) que se borra al terminar.
+* * -a, -r, -k, -l, -e, -g y -x, como en build/radar.
+* * <captura> Archivo de pulsos a medir ("pulsos.iq" por defecto).
+*
+* @param argc Cantidad de argumentos.
+* @param argv[] Argumentos.
+* @param opciones Opciones a completar.
+*/
+static void
+procesar_argumentos_benchmark(int argc, char *argv[], struct OpcionesBenchmark *opciones){
+	for (int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i],"-n") == 0 && i+1 < argc){
+			i++;
+			if(atoi(argv[i]) > 0){
+				opciones->iteraciones = atoi(argv[i]);
+			}
+			else{
+				printf("Numero de iteraciones invalido "BOLDRED"%s\n"RESET, argv[i]);
+			}
+		}
+		else if(strcmp(argv[i],"-w") == 0 && i+1 < argc){
+			i++;
+			if(atoi(argv[i]) >= 0 && isdigit((unsigned char)argv[i][0])){
+				opciones->calentamiento = atoi(argv[i]);
+			}
+			else{
+				printf("Numero de iteraciones de calentamiento invalido "BOLDRED"%s\n"RESET, argv[i]);
+			}
+		}
+		else if(strcmp(argv[i],"-h") == 0 && i+1 < argc){
+			i++;
+			if(leer_lista_hilos(argv[i], opciones) != 0){
+				printf(BOLDRED"Error"RESET", lista de hilos invalida "BOLDRED"%s\n"RESET, argv[i]);
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if(strcmp(argv[i],"-o") == 0 && i+1 < argc){
+			opciones->salida = argv[++i];
+		}
+		else if(strcmp(argv[i],"-j") == 0 && i+1 < argc){
+			opciones->json = argv[++i];
+		}
+		else if(strcmp(argv[i],"-a") == 0 && i+1 < argc){
+			i++;
+			if(motor_por_nombre(argv[i]) >= 0){
+				opciones->motor = motor_por_nombre(argv[i]);
+			}
+			else{
+				printf("No se reconoce el motor de autocorrelacion "BOLDRED"%s\n"RESET, argv[i]);
+			}
+		}
+		else if(strcmp(argv[i],"-r") == 0 && i+1 < argc){
+			i++;
+			if(lectura_por_nombre(argv[i]) >= 0){
+				opciones->lectura = lectura_por_nombre(argv[i]);
+			}
+			else{
+				printf("No se reconoce el metodo de lectura "BOLDRED"%s\n"RESET, argv[i]);
+			}
+		}
+		else if(strcmp(argv[i],"-k") == 0 && i+1 < argc){
+			opciones->kernels = argv[++i];
+		}
+		else if(strcmp(argv[i],"-l") == 0 && i+1 < argc){
+			i++;
+			if(atoi(argv[i]) >= 0 && isdigit((unsigned char)argv[i][0])){
+				opciones->num_lags = atoi(argv[i]) + 1;
+			}
+			else{
+				printf("Desplazamiento maximo invalido "BOLDRED"%s\n"RESET, argv[i]);
+			}
+		}
+		else if(strcmp(argv[i],"-e") == 0 && i+1 < argc){
+			i++;
+			if(codificacion_formato(argv[i]) >= 0){
+				opciones->formato = codificacion_formato(argv[i]);
+			}
+			else{
+				printf("No se reconoce el formato de resultados "BOLDRED"%s\n"RESET, argv[i]);
+			}
+		}
+		else if(strcmp(argv[i],"-g") == 0 && i+1 < argc){
+			i++;
+			if(atoi(argv[i]) > 0 && atoi(argv[i]) <= MAX_GATES){
+				radar.num_gates = atoi(argv[i]);
+			}
+			else{
+				printf("Numero de gates invalido "BOLDRED"%s\n"RESET, argv[i]);
+			}
+		}
+		else if(strcmp(argv[i],"-x") == 0 && i+1 < argc){
+			i++;
+			if(atoi(argv[i]) > 0 && atoi(argv[i]) <= UINT16_MAX){
+				radar.max_muestras = atoi(argv[i]);
+			}
+			else{
+				printf("Numero maximo de muestras invalido "BOLDRED"%s\n"RESET, argv[i]);
+			}
+		}
+		else if(argv[i][0] != '-'){
+			opciones->captura = argv[i];
+		}
+		else{
+			printf("No se reconoce el comando "BOLDRED"%s\n"RESET, argv[i]);
+		}
+	}
+}
+
+ /**
+* @brief Función main del programa de medicion.
+*
+* Mide el procesamiento de la captura con cada numero de hilos pedido,
+* muestra un resumen por salida standard y guarda el detalle en JSON.
+*/
+int
+main(int argc, char *argv[])
+{
+	struct OpcionesBenchmark opciones = {0};
+	opciones.captura = "pulsos.iq";
+	opciones.json = "benchmark.json";
+	opciones.iteraciones = ITERACIONES_DEFECTO;
+	opciones.calentamiento = CALENTAMIENTO_DEFECTO;
+	for (int hilos = 1; hilos < omp_get_max_threads() && opciones.num_corridas < MAX_CORRIDAS - 1; hilos *= 2)
+	{
+		opciones.hilos[opciones.num_corridas++] = hilos;
+	}
+	opciones.hilos[opciones.num_corridas++] = omp_get_max_threads();
+
+	procesar_argumentos_benchmark(argc, argv, &opciones);
+	char temporal[4096];
+	if(opciones.salida == NULL){
+		const char *directorio = getenv("TMPDIR") != NULL ? getenv("TMPDIR") : "/tmp";
+		int fd = -1;
+		if(snprintf(temporal, sizeof(temporal), "%s/radar_benchmark_XXXXXX", directorio) < (int)sizeof(temporal)){
+			fd = mkstemp(temporal);
+		}
+		if(fd < 0){
+			printf(BOLDRED"No se pudo crear un archivo temporal en '%s', indique uno con -o\n"RESET, directorio);
+			exit(EXIT_FAILURE);
+		}
+		close(fd);
+		opciones.salida = temporal;
+	}
+	else{
+		temporal[0] = '\0';
+	}
+	struct Gate gates[radar.num_gates];
+	struct Corrida corridas[MAX_CORRIDAS];
+	struct Problema problema;
+
+	const char *kernels = inicializar_simd(opciones.kernels);
+	opciones.lectura = elegir_lectura(opciones.lectura, opciones.captura);
+	printf("Midiendo "BOLDGREEN"'%s'"RESET": %d iteraciones (%d de calentamiento), lectura %s, kernels %s\n",
+		opciones.captura, opciones.iteraciones, opciones.calentamiento, nombre_lectura(opciones.lectura), kernels);
+
+	for (int c = 0; c < opciones.num_corridas; ++c)
+	{
+		if(medir_corrida(&opciones, gates, opciones.hilos[c], &corridas[c], &problema) != 0){
+			printf(BOLDRED"Error procesando '%s' con %d hilos\n"RESET, opciones.captura, opciones.hilos[c]);
+			if(temporal[0] != '\0') remove(temporal);
+			exit(EXIT_FAILURE);
+		}
+		printf("%4d hilos (%s):", opciones.hilos[c], nombre_ejecucion(opciones.hilos[c]));
+		for (int e = 0; e <= NUM_ETAPAS; ++e)
+		{
+			printf(" %s "BOLDGREEN"%.4f"RESET, nombres_etapas[e], corridas[c].etapas[e].mediana);
+		}
+		printf(" s, eficiencia "BOLDGREEN"%.2f"RESET"\n",
+			corridas[0].etapas[NUM_ETAPAS].mediana * corridas[0].hilos / (corridas[c].etapas[NUM_ETAPAS].mediana * corridas[c].hilos));
+	}
+	printf("Motor de autocorrelacion: "BOLDGREEN"%s"RESET", %d pulsos, %ld muestras\n",
+		nombre_motor(problema.motor), problema.num_pulsos, problema.num_muestras);
+	if(temporal[0] != '\0') remove(temporal);
+
+	if(guardar_json(opciones.json, &opciones, &problema, corridas, kernels) != 0){
+		printf(BOLDRED"Error guardando resultados de la medicion\n"RESET);
+		exit(EXIT_FAILURE);
+	}
+	printf("Resultados guardados en "BOLDGREEN"'%s'\n"RESET, opciones.json);
+	return 0;
+}
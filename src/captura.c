@@ -0,0 +1,208 @@
+/** @file captura.c
+ *  @brief Lectura de capturas del radar mapeadas en memoria.
+ *
+ *  Mapea el archivo de pulsos una unica vez y arma una vista por pulso.
+ *  Tanto el conteo de pulsos como el acceso a las muestras se reducen a
+ *  aritmetica de punteros sobre el mapeo.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/radar.h"
+#include "../include/captura.h"
+#include "../include/ingesta.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+* @brief Recorre los encabezados de los pulsos mapeados.
+*
+* Salta de encabezado en encabezado usando el valor valid_samples de cada tabla.
+* Si vistas no es NULL, guarda ademas la vista de cada pulso.
+*
+* @param captura Captura ya mapeada.
+* @param vistas Arreglo donde guardar las vistas, o NULL para solo contar.
+* @return Numero de pulsos encontrados, o -1 si el archivo esta truncado o
+* algun pulso tiene mas de radar.max_muestras muestras, como en leer_archivo().
+*/
+static int
+recorrer_pulsos(const struct Captura *captura, struct VistaPulso vistas[]){
+	size_t offset = 0;
+	int num_pulsos = 0;
+	uint16_t valid_samples;
+
+	while(offset < captura->tamano){
+		if(captura->tamano - offset < sizeof(uint16_t)){
+			return -1;
+		}
+		memcpy(&valid_samples, captura->base + offset, sizeof(uint16_t));
+		offset += sizeof(uint16_t);
+		if(valid_samples > radar.max_muestras){
+			return -1;
+		}
+
+		size_t len_tabla = (size_t)valid_samples*4*sizeof(float);
+		if(captura->tamano - offset < len_tabla){
+			return -1;
+		}
+		if(vistas != NULL){
+			vistas[num_pulsos].valid_samples = valid_samples;
+			vistas[num_pulsos].datos = captura->base + offset;
+		}
+		offset += len_tabla;
+		num_pulsos++;
+	}
+	return num_pulsos;
+}
+
+/**
+* @brief Arma la vista de cada pulso de una captura ya cargada en memoria.
+*
+* Si se dispone del indice de la captura, las vistas se arman a partir de el
+* sin recorrer la captura.
+*
+* @param captura Captura con base y tamano ya asignados.
+* @param indice Indice de la captura, o NULL para recorrerla.
+* @return 1 si la captura esta truncada o vacia, o algun pulso tiene mas de
+* radar.max_muestras muestras, 0 caso contrario.
+*/
+static int
+armar_vistas(struct Captura *captura, const struct IndicePulsos *indice){
+	if(indice != NULL){
+		captura->num_pulsos = indice->num_pulsos;
+		captura->pulsos = safe_malloc(sizeof(struct VistaPulso) * captura->num_pulsos);
+		for (int i = 0; i < indice->num_pulsos; ++i)
+		{
+			if(indice->valid_samples[i] > radar.max_muestras
+				|| indice->offsets[i] + sizeof(uint16_t) + indice->valid_samples[i]*4*sizeof(float) > captura->tamano){
+				printf(BOLDRED"El pulso %d del indice no coincide con la captura o tiene mas de %d muestras\n"RESET,
+					i, radar.max_muestras);
+				free(captura->pulsos);
+				captura->pulsos = NULL;
+				return 1;
+			}
+			captura->pulsos[i].valid_samples = indice->valid_samples[i];
+			captura->pulsos[i].datos = captura->base + indice->offsets[i] + sizeof(uint16_t);
+		}
+		return 0;
+	}
+
+	captura->num_pulsos = recorrer_pulsos(captura, NULL);
+	if(captura->num_pulsos <= 0){
+		printf(BOLDRED"Archivo de pulsos truncado, vacio o con pulsos de mas de %d muestras\n"RESET, radar.max_muestras);
+		return 1;
+	}
+	captura->pulsos = safe_malloc(sizeof(struct VistaPulso) * captura->num_pulsos);
+	recorrer_pulsos(captura, captura->pulsos);
+
+	printf("Se encontró informacion de "BOLDGREEN"%d"RESET" pulsos.\n", captura->num_pulsos);
+	return 0;
+}
+
+/**
+* @brief Mapea en memoria un archivo de pulsos y arma la vista de cada pulso.
+*
+* Abre el archivo, lo mapea completo en modo solo lectura y lo recorre para
+* contar los pulsos y ubicar sus tablas. Si se dispone del indice de la
+* captura, las vistas se arman a partir de el sin recorrer el mapeo.
+* Las muestras no se copian: cada struct VistaPulso apunta directamente al mapeo.
+*
+* @param file_name[] El nombre del archivo a leer.
+* @param indice Indice de la captura, o NULL para recorrerla.
+* @param captura Estructura donde guardar el mapeo y las vistas.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+abrir_captura(char file_name[], const struct IndicePulsos *indice, struct Captura *captura){
+	struct stat st;
+
+	captura->fd = open(file_name, O_RDONLY);
+	if(captura->fd < 0){
+		printf(BOLDRED"Unable to open file!\n"RESET);
+		return 1;
+	}
+	if(fstat(captura->fd, &st) != 0 || st.st_size == 0){
+		printf(BOLDRED"Error leyendo tamaño del archivo\n"RESET);
+		close(captura->fd);
+		return 1;
+	}
+	captura->tamano = st.st_size;
+	printf("Tamaño del archivo "BOLDGREEN"'%s'"RESET": "BOLDGREEN"%zu"RESET" bytes\n",file_name, captura->tamano);
+
+	void *mapeo = mmap(NULL, captura->tamano, PROT_READ, MAP_PRIVATE, captura->fd, 0);
+	if(mapeo == MAP_FAILED){
+		printf(BOLDRED"Error mapeando archivo\n"RESET);
+		close(captura->fd);
+		return 1;
+	}
+	captura->base = mapeo;
+	madvise(mapeo, captura->tamano, MADV_SEQUENTIAL);
+
+	if(armar_vistas(captura, indice) != 0){
+		munmap(mapeo, captura->tamano);
+		close(captura->fd);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+* @brief Lee una captura completa a memoria con ingerir_archivo() y arma la vista de cada pulso.
+*
+* Alternativa a abrir_captura() para discos rapidos: en lugar de resolver
+* fallos de pagina sobre el mapeo, la captura se lee con varias lecturas
+* grandes en vuelo (io_uring o pread en paralelo, con O_DIRECT si es
+* posible), y luego se buscan los limites de los pulsos sobre el buffer. Las
+* vistas se usan igual que las de una captura mapeada.
+*
+* El buffer ocupa lo mismo que la captura: si no entra_en_memoria(), se avisa
+* y la captura se mapea con abrir_captura().
+*
+* @param file_name[] El nombre del archivo a leer.
+* @param indice Indice de la captura, o NULL para recorrerla.
+* @param captura Estructura donde guardar el buffer y las vistas.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+cargar_captura(char file_name[], const struct IndicePulsos *indice, struct Captura *captura){
+	const char *metodo;
+	struct stat st;
+	if(stat(file_name, &st) == 0 && !entra_en_memoria(st.st_size)){
+		printf(BOLDYELLOW"La captura ocupa mas de 1/%d de la memoria fisica, se mapea en lugar de leerla completa\n"RESET,
+			INGESTA_FRACCION_MEMORIA);
+		return abrir_captura(file_name, indice, captura);
+	}
+	void *buffer = ingerir_archivo(file_name, &captura->tamano, &metodo);
+	if(buffer == NULL){
+		return 1;
+	}
+	captura->fd = -1;
+	captura->base = buffer;
+	printf("Tamaño del archivo "BOLDGREEN"'%s'"RESET": "BOLDGREEN"%zu"RESET" bytes, leido con "BOLDGREEN"%s"RESET"\n",
+		file_name, captura->tamano, metodo);
+
+	if(armar_vistas(captura, indice) != 0){
+		munmap(buffer, captura->tamano);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+* @brief Libera el mapeo y las vistas de una captura.
+*
+* Las vistas dejan de ser validas luego de llamar a esta funcion.
+*
+* @param captura Captura abierta con abrir_captura() o cargar_captura().
+*/
+void
+cerrar_captura(struct Captura *captura){
+	free(captura->pulsos);
+	munmap((void *)captura->base, captura->tamano);
+	if(captura->fd >= 0){
+		close(captura->fd);
+	}
+	captura->pulsos = NULL;
+	captura->base = NULL;
+}
@@ -0,0 +1,435 @@
+/** @file comparar.c
+ *  @brief Comparacion de resultados con tolerancia y deteccion de regresiones.
+ *
+ *  Con dos archivos de resultados (de guardar_archivo(), en cualquier formato
+ *  o codificacion), compara cada desplazamiento de cada gate con el de la
+ *  referencia. Un valor es correcto si esta a lo sumo a -u ULPs del de
+ *  referencia, o si su diferencia no supera -t veces el desplazamiento 0 de su
+ *  vector en la referencia: la misma cota que FFT_TOLERANCIA, ya que el
+ *  desplazamiento 0 acota a todos los demas. Asi pueden compararse motores que
+ *  suman en otro orden (SIMD, FFT, reducciones por bloques), que no dan
+ *  resultados identicos bit a bit.
+ *
+ *  Con -b, compara dos archivos JSON de build/benchmark y falla si la mediana
+ *  de alguna etapa, con algun numero de hilos, empeora mas que un porcentaje.
+ *
+ *  En ambos modos, el programa termina con estado 1 si la comparacion falla.
+ *
+ *  @author Facundo Maero
+ */
+
+#include "../include/func_radar.h"
+#include <inttypes.h>
+
+#define ULPS_DEFECTO 4
+/*!< Distancia maxima en ULPs, salvo que se indique otra con -u. */
+#define REGRESION_DEFECTO 10.0
+/*!< Empeoramiento maximo de una etapa, en porcentaje, salvo que se indique otro con -p. */
+#define MINIMO_REGRESION_DEFECTO 1e-3
+/*!< Diferencia en segundos por debajo de la cual no se considera regresion,
+salvo que se indique otra con -m: evita fallar por el ruido de etapas muy cortas. */
+#define FALLAS_INFORMADAS 10
+/*!< Numero de valores fuera de tolerancia que se muestran. */
+#define MAX_ETAPAS_JSON 16
+/*!< Numero maximo de etapas por corrida leidas de un JSON. */
+#define MAX_NOMBRE_ETAPA 32
+/*!< Largo maximo del nombre de una etapa. */
+
+struct OpcionesComparar{
+	int regresion_flag;
+	long ulps;
+	double tolerancia;
+	double porcentaje;
+	double minimo;
+	char *archivos[2];
+};
+/*!< Opciones del comparador recibidas por linea de comandos. */
+
+struct Diferencias{
+	long comparados;
+	long fallas;
+	long nan;
+	int64_t max_ulps;
+	double max_relativo;
+};
+/*!< Resumen de la comparacion de valores. nan cuenta los valores que son NaN en
+un solo archivo, que no entran en max_ulps ni en max_relativo. */
+
+struct EtapaJson{
+	char nombre[MAX_NOMBRE_ETAPA];
+	double mediana;
+};
+/*!< Mediana de una etapa en una corrida de build/benchmark. */
+
+/**
+* @brief Distancia en ULPs entre dos floats: cuantos floats representables hay entre ellos.
+*
+* @param a Primer valor.
+* @param b Segundo valor.
+* @return Distancia en ULPs. Entre +0 y -0 es 0.
+*/
+static int64_t
+distancia_ulps(float a, float b){
+	int32_t x, y;
+	memcpy(&x, &a, sizeof(x));
+	memcpy(&y, &b, sizeof(y));
+	//los negativos se reflejan para que el orden de los enteros sea el de los floats
+	int64_t ordenado_x = x < 0 ? (int64_t)INT32_MIN - x : x;
+	int64_t ordenado_y = y < 0 ? (int64_t)INT32_MIN - y : y;
+	return ordenado_x > ordenado_y ? ordenado_x - ordenado_y : ordenado_y - ordenado_x;
+}
+
+/**
+* @brief Compara un vector de autocorrelacion con el de referencia.
+*
+* El error relativo solo se mide si el desplazamiento 0 de la referencia es
+* finito y distinto de 0, y ambos valores son finitos; si no, el valor se
+* juzga solo por su distancia en ULPs.
+*
+* @param opciones Tolerancias.
+* @param referencia[] Vector de referencia.
+* @param valores[] Vector a comparar.
+* @param num_lags Largo de los vectores.
+* @param bloque Numero de bloque, para informar fallas.
+* @param gate Numero de gate.
+* @param componente 'V' o 'H'.
+* @param diferencias Resumen a actualizar.
+*/
+static void
+comparar_vector(const struct OpcionesComparar *opciones, const float referencia[], const float valores[], int num_lags,
+	int bloque, int gate, char componente, struct Diferencias *diferencias){
+	double escala = num_lags > 0 ? fabs(referencia[0]) : 0;
+	int con_escala = isfinite(escala) && escala > 0;
+	for (int l = 0; l < num_lags; ++l)
+	{
+		float a = referencia[l], b = valores[l];
+		if(isnan(a) && isnan(b)){
+			continue;
+		}
+		diferencias->comparados++;
+		if(isnan(a) || isnan(b)){
+			if(diferencias->fallas < FALLAS_INFORMADAS){
+				printf("  bloque %d, gate %d, %c[%d]: referencia %.9g, valor %.9g (NaN en un solo archivo)\n",
+					bloque, gate, componente, l, a, b);
+			}
+			diferencias->nan++;
+			diferencias->fallas++;
+			continue;
+		}
+
+		int64_t ulps = distancia_ulps(a, b);
+		double diferencia = fabs((double)a - b);
+		int relativo_valido = con_escala && isfinite(a) && isfinite(b);
+		double relativo = relativo_valido ? diferencia / escala : 0;
+		int correcto = ulps <= opciones->ulps || (relativo_valido && diferencia <= opciones->tolerancia * escala);
+
+		if(ulps > diferencias->max_ulps){
+			diferencias->max_ulps = ulps;
+		}
+		if(relativo > diferencias->max_relativo){
+			diferencias->max_relativo = relativo;
+		}
+		if(!correcto && diferencias->fallas < FALLAS_INFORMADAS){
+			if(relativo_valido){
+				printf("  bloque %d, gate %d, %c[%d]: referencia %.9g, valor %.9g (%" PRId64 " ULPs, %.3g relativo)\n",
+					bloque, gate, componente, l, a, b, ulps, relativo);
+			}
+			else{
+				printf("  bloque %d, gate %d, %c[%d]: referencia %.9g, valor %.9g (%" PRId64 " ULPs, sin error relativo)\n",
+					bloque, gate, componente, l, a, b, ulps);
+			}
+		}
+		diferencias->fallas += !correcto;
+	}
+}
+
+/**
+* @brief Compara dos archivos de resultados, bloque por bloque.
+*
+* @param opciones Opciones del comparador.
+* @return 1 si los archivos difieren mas que la tolerancia o no pueden leerse, 0 caso contrario.
+*/
+static int
+comparar_resultados(const struct OpcionesComparar *opciones){
+	FILE *f[2];
+	struct Diferencias diferencias = {0};
+	int error = 0, bloques = 0;
+
+	for (int i = 0; i < 2; ++i)
+	{
+		f[i] = fopen(opciones->archivos[i], "rb");
+		if(!f[i]){
+			printf(BOLDRED"No se pudo abrir '%s'\n"RESET, opciones->archivos[i]);
+			if(i == 1){
+				fclose(f[0]);
+			}
+			return 1;
+		}
+	}
+
+	for(;;){
+		int c0 = fgetc(f[0]), c1 = fgetc(f[1]);
+		if(c0 == EOF || c1 == EOF){
+			if(c0 != c1){
+				printf(BOLDRED"Los archivos tienen distinto numero de bloques (%d en comun)\n"RESET, bloques);
+				error = 1;
+			}
+			break;
+		}
+		ungetc(c0, f[0]);
+		ungetc(c1, f[1]);
+
+		struct BloqueResultados referencia, resultado;
+		if(leer_resultados(f[0], &referencia) != 0){
+			printf(BOLDRED"Error leyendo el bloque %d de '%s'\n"RESET, bloques, opciones->archivos[0]);
+			error = 1;
+			break;
+		}
+		if(leer_resultados(f[1], &resultado) != 0){
+			printf(BOLDRED"Error leyendo el bloque %d de '%s'\n"RESET, bloques, opciones->archivos[1]);
+			liberar_resultados(&referencia);
+			error = 1;
+			break;
+		}
+		if(referencia.num_gates != resultado.num_gates || referencia.num_lags != resultado.num_lags
+			|| (referencia.num_pulsos != 0 && resultado.num_pulsos != 0 && referencia.num_pulsos != resultado.num_pulsos)){
+			printf(BOLDRED"El bloque %d no tiene las mismas dimensiones: %d gates y %d desplazamientos contra %d y %d\n"RESET,
+				bloques, referencia.num_gates, referencia.num_lags, resultado.num_gates, resultado.num_lags);
+			error = 1;
+		}
+		for (int g = 0; g < referencia.num_gates && !error; ++g)
+		{
+			size_t inicio = (size_t)g * referencia.num_lags;
+			comparar_vector(opciones, referencia.vertical + inicio, resultado.vertical + inicio, referencia.num_lags, bloques, g, 'V', &diferencias);
+			comparar_vector(opciones, referencia.horizontal + inicio, resultado.horizontal + inicio, referencia.num_lags, bloques, g, 'H', &diferencias);
+		}
+		liberar_resultados(&referencia);
+		liberar_resultados(&resultado);
+		bloques++;
+		if(error){
+			break;
+		}
+	}
+	fclose(f[0]);
+	fclose(f[1]);
+
+	printf("Bloques: %d, valores comparados: %ld, fuera de tolerancia: %s%ld"RESET"\n",
+		bloques, diferencias.comparados, diferencias.fallas ? BOLDRED : BOLDGREEN, diferencias.fallas);
+	printf("Maxima distancia: %" PRId64 " ULPs, maximo error relativo al desplazamiento 0: %.3g (tolerancia %ld ULPs o %.3g)\n",
+		diferencias.max_ulps, diferencias.max_relativo, opciones->ulps, opciones->tolerancia);
+	if(diferencias.nan > 0){
+		printf(BOLDRED"Valores NaN en un solo archivo: %ld\n"RESET, diferencias.nan);
+	}
+	return error || diferencias.fallas > 0;
+}
+
+/**
+* @brief Lee un archivo completo a memoria, terminado en '\0'.
+*
+* @param filename[] Nombre del archivo.
+* @return Contenido del archivo, o NULL si no pudo leerse.
+*/
+static char *
+leer_texto(char filename[]){
+	FILE *f = fopen(filename, "rb");
+	if(!f){
+		return NULL;
+	}
+	char *texto = NULL;
+	long tamano;
+	if(fseek(f, 0, SEEK_END) == 0 && (tamano = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0){
+		texto = safe_malloc(tamano + 1);
+		if(fread(texto, 1, tamano, f) != (size_t)tamano){
+			free(texto);
+			texto = NULL;
+		}
+		else{
+			texto[tamano] = '\0';
+		}
+	}
+	fclose(f);
+	return texto;
+}
+
+/**
+* @brief Busca la siguiente corrida en el JSON de build/benchmark.
+*
+* No es un lector de JSON general: se apoya en el formato que escribe
+* build/benchmark, donde cada corrida comienza con su clave "hilos" y cada
+* etapa es un objeto que comienza con "mediana".
+*
+* @param texto Posicion desde la que buscar. Se avanza al final de la corrida.
+* @param hilos Numero de hilos de la corrida.
+* @param etapas[] Mediana de cada etapa de la corrida.
+* @return Numero de etapas leidas, o -1 si no hay mas corridas.
+*/
+static int
+siguiente_corrida(const char **texto, int *hilos, struct EtapaJson etapas[]){
+	const char *corrida = strstr(*texto, "\"hilos\":");
+	if(corrida == NULL){
+		return -1;
+	}
+	*hilos = atoi(corrida + strlen("\"hilos\":"));
+	const char *fin = strstr(corrida + 1, "\"hilos\":");
+	int n = 0;
+
+	for (const char *etapa = strstr(corrida, "\"mediana\":"); etapa != NULL && (fin == NULL || etapa < fin) && n < MAX_ETAPAS_JSON;
+		etapa = strstr(etapa + 1, "\"mediana\":"))
+	{
+		//la clave de la etapa es la cadena entre comillas anterior al objeto
+		const char *cierre = etapa - 1;
+		while(cierre > corrida && *cierre != '"'){
+			cierre--;
+		}
+		const char *apertura = cierre - 1;
+		while(apertura > corrida && *apertura != '"'){
+			apertura--;
+		}
+		size_t largo = cierre - apertura - 1;
+		if(largo >= MAX_NOMBRE_ETAPA){
+			largo = MAX_NOMBRE_ETAPA - 1;
+		}
+		memcpy(etapas[n].nombre, apertura + 1, largo);
+		etapas[n].nombre[largo] = '\0';
+		etapas[n].mediana = strtod(etapa + strlen("\"mediana\":"), NULL);
+		n++;
+	}
+	*texto = fin != NULL ? fin : corrida + strlen(corrida);
+	return n;
+}
+
+/**
+* @brief Compara dos mediciones de build/benchmark y detecta regresiones.
+*
+* Para cada corrida de la medicion nueva con el mismo numero de hilos que una
+* de la base, una etapa regresa si su mediana supera a la de la base en mas de
+* -p por ciento y en mas de -m segundos.
+*
+* @param opciones Opciones del comparador.
+* @return 1 si alguna etapa regreso o los archivos no pueden leerse, 0 caso contrario.
+*/
+static int
+comparar_mediciones(const struct OpcionesComparar *opciones){
+	char *base = leer_texto(opciones->archivos[0]);
+	char *nuevo = leer_texto(opciones->archivos[1]);
+	int regresiones = 0, comparadas = 0;
+
+	if(base == NULL || nuevo == NULL){
+		printf(BOLDRED"No se pudieron leer las mediciones\n"RESET);
+		free(base);
+		free(nuevo);
+		return 1;
+	}
+
+	const char *posicion_nuevo = nuevo;
+	struct EtapaJson etapas_nuevo[MAX_ETAPAS_JSON], etapas_base[MAX_ETAPAS_JSON];
+	int hilos_nuevo, n_nuevo;
+	while((n_nuevo = siguiente_corrida(&posicion_nuevo, &hilos_nuevo, etapas_nuevo)) >= 0){
+		const char *posicion_base = base;
+		int hilos_base, n_base;
+		while((n_base = siguiente_corrida(&posicion_base, &hilos_base, etapas_base)) >= 0 && hilos_base != hilos_nuevo);
+		if(n_base < 0){
+			printf(BOLDYELLOW"La base no tiene una corrida con %d hilos\n"RESET, hilos_nuevo);
+			continue;
+		}
+		for (int e = 0; e < n_nuevo; ++e)
+		{
+			for (int b = 0; b < n_base; ++b)
+			{
+				if(strcmp(etapas_nuevo[e].nombre, etapas_base[b].nombre) != 0){
+					continue;
+				}
+				double antes = etapas_base[b].mediana, ahora = etapas_nuevo[e].mediana;
+				double cambio = antes > 0 ? 100 * (ahora - antes) / antes : 0;
+				int regresa = ahora - antes > opciones->minimo && cambio > opciones->porcentaje;
+				printf("%4d hilos, %-16s %10.6f -> %10.6f s (%s%+.1f%%"RESET")%s\n", hilos_nuevo, etapas_nuevo[e].nombre,
+					antes, ahora, regresa ? BOLDRED : (cambio < 0 ? BOLDGREEN : ""), cambio, regresa ? BOLDRED" regresion"RESET : "");
+				regresiones += regresa;
+				comparadas++;
+			}
+		}
+	}
+	free(base);
+	free(nuevo);
+
+	if(comparadas == 0){
+		printf(BOLDRED"Las mediciones no tienen corridas en comun\n"RESET);
+		return 1;
+	}
+	printf("Etapas comparadas: %d, regresiones: %s%d"RESET" (umbral %.1f%% y %.3g s)\n",
+		comparadas, regresiones ? BOLDRED : BOLDGREEN, regresiones, opciones->porcentaje, opciones->minimo);
+	return regresiones > 0;
+}
+
+/**
+* @brief Procesa los argumentos del comparador.
+*
+* Los valores aceptados son:
+* * -u <ulps> Distancia maxima en ULPs (4 por defecto).
+* * -t <tolerancia> Diferencia maxima relativa al desplazamiento 0 del vector (FFT_TOLERANCIA por defecto).
+* * -g <gates> Numero de gates de los archivos en el formato original.
+* * -b Compara dos mediciones JSON de build/benchmark en lugar de dos archivos de resultados.
+* * -p <porcentaje> Empeoramiento maximo de una etapa (10 por defecto).
+* * -m <segundos> Diferencia minima para considerar una regresion (0.001 por defecto).
+* * <referencia> <resultado> Archivos a comparar, primero la referencia o la base.
+*
+* @param argc Cantidad de argumentos.
+* @param argv[] Argumentos.
+* @param opciones Opciones a completar.
+* @return Numero de archivos recibidos.
+*/
+static int
+procesar_argumentos_comparar(int argc, char *argv[], struct OpcionesComparar *opciones){
+	int archivos = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i],"-u") == 0 && i+1 < argc){
+			opciones->ulps = atol(argv[++i]);
+		}
+		else if(strcmp(argv[i],"-t") == 0 && i+1 < argc){
+			opciones->tolerancia = atof(argv[++i]);
+		}
+		else if(strcmp(argv[i],"-p") == 0 && i+1 < argc){
+			opciones->porcentaje = atof(argv[++i]);
+		}
+		else if(strcmp(argv[i],"-m") == 0 && i+1 < argc){
+			opciones->minimo = atof(argv[++i]);
+		}
+		else if(strcmp(argv[i],"-b") == 0){
+			opciones->regresion_flag = 1;
+		}
+		else if(strcmp(argv[i],"-g") == 0 && i+1 < argc){
+			i++;
+			if(atoi(argv[i]) > 0 && atoi(argv[i]) <= MAX_GATES){
+				radar.num_gates = atoi(argv[i]);
+			}
+			else{
+				printf("Numero de gates invalido "BOLDRED"%s\n"RESET, argv[i]);
+			}
+		}
+		else if(argv[i][0] != '-' && archivos < 2){
+			opciones->archivos[archivos++] = argv[i];
+		}
+		else{
+			printf("No se reconoce el comando "BOLDRED"%s\n"RESET, argv[i]);
+		}
+	}
+	return archivos;
+}
+
+ /**
+* @brief Función main del comparador.
+*/
+int
+main(int argc, char *argv[])
+{
+	struct OpcionesComparar opciones = {0, ULPS_DEFECTO, FFT_TOLERANCIA, REGRESION_DEFECTO, MINIMO_REGRESION_DEFECTO, {NULL, NULL}};
+
+	if(procesar_argumentos_comparar(argc, argv, &opciones) != 2){
+		printf("Uso: comparar [-u ulps] [-t tolerancia] [-g gates] <referencia> <resultado>\n");
+		printf("     comparar -b [-p porcentaje] [-m segundos] <base.json> <nuevo.json>\n");
+		return EXIT_FAILURE;
+	}
+	int error = opciones.regresion_flag ? comparar_mediciones(&opciones) : comparar_resultados(&opciones);
+	return error ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,203 @@
+/** @file contadores.c
+ *  @brief Lectura de contadores de hardware con perf_event_open.
+ *
+ *  Cada hilo de OpenMP abre sus propios contadores, que cuentan solo ese hilo
+ *  y en modo usuario (lo que admite perf_event_paranoid hasta 2). Al iniciar y
+ *  al terminar una region se abre un equipo de OpenMP en el que cada hilo lee
+ *  sus contadores: el runtime reutiliza los hilos de un equipo al siguiente,
+ *  por lo que los del motor son los mismos que se miden. Los hilos que no
+ *  participan de una etapa (por ejemplo en su parte secuencial) aportan
+ *  valores cercanos a 0.
+ *
+ *  Solo se compila con make CONTADORES=1.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/radar.h"
+#include "../include/contadores.h"
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <omp.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define NUM_EVENTOS 4
+/*!< Numero de eventos contados por hilo. */
+
+struct Evento{
+	uint32_t tipo;
+	uint64_t config;
+	const char *nombre;
+};
+/*!< Evento de hardware de perf_event_open. */
+
+static const struct Evento eventos[NUM_EVENTOS] = {
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "ciclos"},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instrucciones"},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, "fallos LLC"},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND, "ciclos detenidos"}
+};
+
+static const char *nombres_regiones[NUM_REGIONES] = {
+	"lectura", "modulo", "autocorrelacion", "escritura"
+};
+
+static _Thread_local int descriptores[NUM_EVENTOS];
+static _Thread_local int abiertos;
+static double inicio[MAX_HILOS_CONTADOS][NUM_EVENTOS];
+static double acumulado[NUM_REGIONES][MAX_HILOS_CONTADOS][NUM_EVENTOS];
+static int disponible[NUM_EVENTOS];
+static int error_apertura;
+static int hilos_contados;
+static int usadas[NUM_REGIONES];
+
+/**
+* @brief Abre los contadores del hilo que llama, la primera vez.
+*
+* Un evento que el procesador o el kernel no admiten queda con descriptor -1
+* y se informa como no disponible.
+*/
+static void
+abrir_contadores_hilo(void){
+	if(abiertos){
+		return;
+	}
+	for (int e = 0; e < NUM_EVENTOS; ++e)
+	{
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = eventos[e].tipo;
+		attr.config = eventos[e].config;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		descriptores[e] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		if(descriptores[e] >= 0){
+			#pragma omp atomic write
+			disponible[e] = 1;
+		}
+		else{
+			#pragma omp atomic write
+			error_apertura = errno;
+		}
+	}
+	abiertos = 1;
+}
+
+/**
+* @brief Lee los contadores del hilo que llama.
+*
+* Si el kernel multiplexa los contadores (hay mas eventos que registros), el
+* valor se escala por la fraccion del tiempo en que el evento estuvo activo.
+*
+* @param valores[] Valor de cada evento, o 0 si no esta disponible.
+*/
+static void
+leer_contadores_hilo(double valores[]){
+	for (int e = 0; e < NUM_EVENTOS; ++e)
+	{
+		uint64_t lectura[3];
+		valores[e] = 0;
+		if(descriptores[e] >= 0 && read(descriptores[e], lectura, sizeof(lectura)) == sizeof(lectura) && lectura[2] > 0){
+			valores[e] = (double)lectura[0] * lectura[1] / lectura[2];
+		}
+	}
+}
+
+/**
+* @brief Registra los contadores de cada hilo al iniciar una region.
+*
+* @param region Region que comienza (REGION_LECTURA, ...).
+*/
+void
+iniciar_region(int region){
+	(void)region;
+	#pragma omp parallel
+	{
+		int hilo = omp_get_thread_num();
+		abrir_contadores_hilo();
+		if(hilo < MAX_HILOS_CONTADOS){
+			leer_contadores_hilo(inicio[hilo]);
+		}
+	}
+}
+
+/**
+* @brief Suma a una region lo contado por cada hilo desde iniciar_region().
+*
+* @param region Region que termina.
+*/
+void
+terminar_region(int region){
+	#pragma omp parallel
+	{
+		int hilo = omp_get_thread_num();
+		double valores[NUM_EVENTOS];
+		abrir_contadores_hilo();
+		if(hilo < MAX_HILOS_CONTADOS){
+			leer_contadores_hilo(valores);
+			for (int e = 0; e < NUM_EVENTOS; ++e)
+			{
+				acumulado[region][hilo][e] += valores[e] - inicio[hilo][e];
+			}
+		}
+	}
+	usadas[region] = 1;
+	if(omp_get_max_threads() > hilos_contados){
+		hilos_contados = omp_get_max_threads() < MAX_HILOS_CONTADOS ? omp_get_max_threads() : MAX_HILOS_CONTADOS;
+	}
+}
+
+/**
+* @brief Muestra por salida standard los contadores de cada region, por hilo y en total.
+*/
+void
+informar_contadores(void){
+	int alguno = 0;
+	for (int e = 0; e < NUM_EVENTOS; ++e)
+	{
+		alguno |= disponible[e];
+	}
+	if(!alguno){
+		printf(BOLDYELLOW"No se pudieron abrir los contadores de hardware (perf_event_open: %s)\n"RESET, strerror(error_apertura));
+		return;
+	}
+
+	printf("Contadores de hardware por etapa:\n");
+	for (int r = 0; r < NUM_REGIONES; ++r)
+	{
+		if(!usadas[r]){
+			continue;
+		}
+		double total[NUM_EVENTOS] = {0};
+		for (int h = 0; h <= hilos_contados; ++h)
+		{
+			const double *valores = h < hilos_contados ? acumulado[r][h] : total;
+			if(h < hilos_contados){
+				for (int e = 0; e < NUM_EVENTOS; ++e)
+				{
+					total[e] += valores[e];
+				}
+				printf("  %-16s hilo %3d:", nombres_regiones[r], h);
+			}
+			else{
+				printf("  %-16s "BOLDGREEN"   total"RESET":", nombres_regiones[r]);
+			}
+			for (int e = 0; e < NUM_EVENTOS; ++e)
+			{
+				if(disponible[e]){
+					printf(" %s %.0f", eventos[e].nombre, valores[e]);
+				}
+				else{
+					printf(" %s n/d", eventos[e].nombre);
+				}
+			}
+			if(disponible[0] && disponible[1] && valores[0] > 0){
+				printf(" IPC %.2f", valores[1] / valores[0]);
+			}
+			printf("\n");
+		}
+	}
+}
@@ -0,0 +1,179 @@
+/** @file fft.c
+ *  @brief Autocorrelacion por FFT (teorema de Wiener–Khinchin).
+ *
+ *  FFT compleja iterativa radix-2 en doble precision. Como los vectores de
+ *  los gates son reales, las componentes vertical y horizontal de un gate se
+ *  transforman juntas, como parte real e imaginaria de un mismo vector.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/radar.h"
+#include "../include/fft.h"
+#include <math.h>
+
+/**
+* @brief Prepara el plan de FFT para vectores de una longitud dada.
+*
+* Para calcular solo los primeros num_lags desplazamientos alcanza con
+* completar el vector hasta len + num_lags - 1: la correlacion circular solo
+* mezcla los extremos en los desplazamientos mayores.
+*
+* @param plan Plan a inicializar.
+* @param len Longitud de los vectores a correlacionar (numero de pulsos).
+* @param num_lags Numero de desplazamientos a calcular, como maximo len.
+*/
+void
+crear_plan_fft(struct PlanFFT *plan, int len, int num_lags){
+	int bits = 0;
+	plan->len = len;
+	plan->num_lags = num_lags;
+	plan->n = 1;
+	while(plan->n < len + num_lags){
+		plan->n <<= 1;
+		bits++;
+	}
+
+	plan->coseno = safe_malloc(sizeof(double) * (plan->n/2 + 1));
+	plan->seno = safe_malloc(sizeof(double) * (plan->n/2 + 1));
+	for (int k = 0; k <= plan->n/2; ++k)
+	{
+		plan->coseno[k] = cos(2*M_PI*k/plan->n);
+		plan->seno[k] = -sin(2*M_PI*k/plan->n);
+	}
+
+	plan->inverso_bits = safe_malloc(sizeof(int) * plan->n);
+	for (int k = 0; k < plan->n; ++k)
+	{
+		int r = 0;
+		for (int b = 0; b < bits; ++b)
+		{
+			r |= ((k >> b) & 1) << (bits-1-b);
+		}
+		plan->inverso_bits[k] = r;
+	}
+}
+
+/**
+* @brief Libera las tablas de un plan de FFT.
+*
+* @param plan Plan creado con crear_plan_fft().
+*/
+void
+destruir_plan_fft(struct PlanFFT *plan){
+	free(plan->coseno);
+	free(plan->seno);
+	free(plan->inverso_bits);
+}
+
+/**
+* @brief Reserva el vector de trabajo de un hilo para un plan dado.
+*
+* Cada hilo que calcule autocorrelaciones con el mismo plan necesita su propio
+* vector de trabajo de n complejos.
+*
+* @param plan Plan de FFT.
+* @return Vector de trabajo, a liberar con free().
+*/
+double *
+crear_trabajo_fft(const struct PlanFFT *plan){
+	return safe_malloc(sizeof(double) * 2*plan->n);
+}
+
+/**
+* @brief FFT compleja en el lugar, radix-2 con reordenamiento de bits.
+*
+* @param plan Plan de FFT.
+* @param datos[] n complejos intercalados (real, imaginario).
+* @param inversa 1 para la transformada inversa (sin normalizar), 0 para la directa.
+*/
+static void
+fft(const struct PlanFFT *plan, double datos[], int inversa){
+	int n = plan->n;
+	double signo = inversa ? -1 : 1;
+
+	for (int k = 0; k < n; ++k)
+	{
+		int r = plan->inverso_bits[k];
+		if(k < r){
+			double re = datos[2*k], im = datos[2*k+1];
+			datos[2*k] = datos[2*r];
+			datos[2*k+1] = datos[2*r+1];
+			datos[2*r] = re;
+			datos[2*r+1] = im;
+		}
+	}
+
+	for (int m = 2; m <= n; m <<= 1)
+	{
+		int paso = n/m;
+		for (int inicio = 0; inicio < n; inicio += m)
+		{
+			for (int k = 0; k < m/2; ++k)
+			{
+				double wr = plan->coseno[k*paso];
+				double wi = signo*plan->seno[k*paso];
+				int a = inicio + k, b = inicio + k + m/2;
+				double tr = wr*datos[2*b] - wi*datos[2*b+1];
+				double ti = wr*datos[2*b+1] + wi*datos[2*b];
+				datos[2*b] = datos[2*a] - tr;
+				datos[2*b+1] = datos[2*a+1] - ti;
+				datos[2*a] += tr;
+				datos[2*a+1] += ti;
+			}
+		}
+	}
+}
+
+/**
+* @brief Calcula la autocorrelacion normalizada de las dos componentes de un gate.
+*
+* Se arma el vector complejo z = v + i*h completado con ceros hasta n, y se
+* transforma. De Z se separan los espectros de ambas componentes:
+* V(k) = (Z(k) + conj(Z(n-k)))/2 y H(k) = (Z(k) - conj(Z(n-k)))/2i.
+* El vector |V(k)|^2 + i*|H(k)|^2 se antitransforma, y su parte real e
+* imaginaria son las autocorrelaciones de v y h respectivamente.
+* Igual que autocorrelacion(), los resultados se dividen por len.
+*
+* @param plan Plan de FFT creado para len = numero de pulsos.
+* @param v[] Vector de modulos verticales del gate.
+* @param h[] Vector de modulos horizontales del gate.
+* @param resultado_v[] Autocorrelacion de v, de plan->num_lags elementos.
+* @param resultado_h[] Autocorrelacion de h, de plan->num_lags elementos.
+* @param trabajo[] Vector de trabajo del hilo, creado con crear_trabajo_fft().
+*/
+void
+autocorrelacion_fft(const struct PlanFFT *plan, const float v[], const float h[],
+	float resultado_v[], float resultado_h[], double trabajo[]){
+	int n = plan->n, len = plan->len;
+
+	for (int k = 0; k < len; ++k)
+	{
+		trabajo[2*k] = v[k];
+		trabajo[2*k+1] = h[k];
+	}
+	for (int k = 2*len; k < 2*n; ++k)
+	{
+		trabajo[k] = 0;
+	}
+
+	fft(plan, trabajo, 0);
+
+	for (int k = 0; k <= n/2; ++k)
+	{
+		int c = (n-k) % n;
+		double a = trabajo[2*k], b = trabajo[2*k+1];
+		double d_re = trabajo[2*c], d_im = trabajo[2*c+1];
+		double potencia_v = ((a+d_re)*(a+d_re) + (b-d_im)*(b-d_im)) / 4;
+		double potencia_h = ((b+d_im)*(b+d_im) + (a-d_re)*(a-d_re)) / 4;
+		trabajo[2*k] = trabajo[2*c] = potencia_v;
+		trabajo[2*k+1] = trabajo[2*c+1] = potencia_h;
+	}
+
+	fft(plan, trabajo, 1);
+
+	for (int k = 0; k < plan->num_lags; ++k)
+	{
+		resultado_v[k] = trabajo[2*k] / n / len;
+		resultado_h[k] = trabajo[2*k+1] / n / len;
+	}
+}
@@ -0,0 +1,523 @@
+/** @file formato.c
+ *  @brief Codificacion y escritura del archivo de resultados.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/radar.h"
+#include "../include/formato.h"
+#include <string.h>
+#include <sys/types.h>
+
+/**
+* @brief Completa la descripcion de un bloque de resultados.
+*
+* Si se pidio el formato original pero el numero de desplazamientos no entra
+* en su uint16_t, se usa el formato versionado con floats y se avisa, en lugar
+* de guardar un numero truncado.
+*
+* @param formato Descripcion a completar.
+* @param codificacion Formato pedido con la opcion -e.
+* @param num_pulsos Numero de pulsos de cada gate.
+* @param num_lags Numero de desplazamientos guardados por gate.
+*/
+void
+preparar_formato(struct Formato *formato, int codificacion, int num_pulsos, int num_lags){
+	formato->codificacion = codificacion;
+	formato->num_pulsos = num_pulsos;
+	formato->num_lags = num_lags;
+	if(codificacion == FORMATO_V1 && num_lags > UINT16_MAX){
+		printf(BOLDYELLOW"%d desplazamientos no entran en el formato v1, se guarda en formato f32\n"RESET, num_lags);
+		formato->codificacion = FORMATO_F32;
+	}
+}
+
+/**
+* @brief Traduce el nombre de una codificacion recibido por linea de comandos.
+*
+* @param nombre[] "v1", "f32", "f16" o "xor".
+* @return Codificacion correspondiente, o -1 si no se reconoce.
+*/
+int
+codificacion_formato(const char nombre[]){
+	if(strcmp(nombre, "v1") == 0){
+		return FORMATO_V1;
+	}
+	if(strcmp(nombre, "f32") == 0){
+		return FORMATO_F32;
+	}
+	if(strcmp(nombre, "f16") == 0){
+		return FORMATO_F16;
+	}
+	if(strcmp(nombre, "xor") == 0){
+		return FORMATO_XOR;
+	}
+	return -1;
+}
+
+/**
+* @brief Bytes del encabezado y la tabla de offsets del formato versionado.
+*
+* @return Offset del primer gate desde el inicio del encabezado.
+*/
+size_t
+bytes_encabezado_formato(void){
+	return sizeof(struct EncabezadoFormato) + sizeof(uint64_t) * (radar.num_gates + 1);
+}
+
+/**
+* @brief Bytes que ocupa cada gate, si todos ocupan lo mismo.
+*
+* @param formato Descripcion del bloque.
+* @return Bytes de cada gate, o 0 si dependen de los datos (FORMATO_XOR).
+*/
+size_t
+bytes_gate_formato(const struct Formato *formato){
+	size_t n = formato->num_lags;
+	switch(formato->codificacion){
+		case FORMATO_V1:
+			return sizeof(uint16_t) + 2*n*sizeof(float);
+		case FORMATO_F32:
+			return 2*n*sizeof(float);
+		case FORMATO_F16:
+			return 2*(sizeof(float) + n*sizeof(uint16_t));
+		default:
+			return 0;
+	}
+}
+
+/**
+* @brief Bytes maximos que puede ocupar un gate codificado con codificar_gate().
+*
+* @param formato Descripcion del bloque.
+* @return Tamaño de buffer suficiente para cualquier gate.
+*/
+size_t
+cota_gate_formato(const struct Formato *formato){
+	size_t n = formato->num_lags;
+	if(formato->codificacion == FORMATO_XOR){
+		return 2*(n*sizeof(float) + (n+1)/2);
+	}
+	return bytes_gate_formato(formato);
+}
+
+/**
+* @brief Convierte un float a half (IEEE 754 de 16 bits), redondeando al par mas cercano.
+*
+* @param valor Valor a convertir.
+* @return Bits del half.
+*/
+static uint16_t
+float_a_half(float valor){
+	uint32_t bits;
+	memcpy(&bits, &valor, sizeof(bits));
+	uint32_t signo = (bits >> 16) & 0x8000;
+	int exponente = (int)((bits >> 23) & 0xff) - 127 + 15;
+	uint32_t mantisa = bits & 0x7fffff;
+	uint32_t half, resto, mitad;
+
+	if(((bits >> 23) & 0xff) == 0xff){
+		//infinito o NaN
+		return signo | 0x7c00 | (mantisa != 0 ? 0x200 : 0);
+	}
+	if(exponente >= 31){
+		return signo | 0x7c00;
+	}
+	if(exponente <= 0){
+		//subnormal en half
+		if(exponente < -10){
+			return signo;
+		}
+		mantisa |= 0x800000;
+		int corrimiento = 14 - exponente;
+		half = mantisa >> corrimiento;
+		resto = mantisa & ((1u << corrimiento) - 1);
+		mitad = 1u << (corrimiento - 1);
+	}
+	else{
+		half = ((uint32_t)exponente << 10) | (mantisa >> 13);
+		resto = mantisa & 0x1fff;
+		mitad = 0x1000;
+	}
+	//un acarreo de la mantisa pasa correctamente al exponente
+	if(resto > mitad || (resto == mitad && (half & 1))){
+		half++;
+	}
+	return signo | half;
+}
+
+/**
+* @brief Convierte un half (IEEE 754 de 16 bits) a float. La conversion es exacta.
+*
+* @param half Bits del half.
+* @return Valor del half.
+*/
+static float
+half_a_float(uint16_t half){
+	uint32_t signo = (uint32_t)(half & 0x8000) << 16;
+	uint32_t exponente = (half >> 10) & 0x1f;
+	uint32_t mantisa = half & 0x3ff;
+	uint32_t bits;
+	float valor;
+
+	if(exponente == 0x1f){
+		bits = signo | 0x7f800000 | (mantisa << 13);
+	}
+	else if(exponente != 0){
+		bits = signo | ((exponente - 15 + 127) << 23) | (mantisa << 13);
+	}
+	else{
+		//cero o subnormal: mantisa * 2^-24
+		valor = (float)mantisa / 16777216.0f;
+		return signo ? -valor : valor;
+	}
+	memcpy(&valor, &bits, sizeof(valor));
+	return valor;
+}
+
+/**
+* @brief Codifica un vector de autocorrelacion.
+*
+* FORMATO_F32 copia los floats. FORMATO_F16 guarda el maximo valor absoluto
+* del vector como float, y cada valor dividido por el como half: la escala
+* evita que valores grandes se desborden a infinito. FORMATO_XOR guarda, para
+* cada valor, el XOR de sus bits con los del anterior: valores vecinos
+* comparten signo, exponente y los bits altos de la mantisa, por lo que el
+* XOR tiene bytes altos nulos que no se guardan. Cada par de valores va
+* precedido por un byte con el numero de bytes guardados de cada uno (0 a 4).
+*
+* @param codificacion FORMATO_F32, FORMATO_F16 o FORMATO_XOR.
+* @param vector[] Valores a codificar.
+* @param n Numero de valores.
+* @param destino[] Buffer de salida.
+* @return Bytes escritos en destino.
+*/
+static size_t
+codificar_vector(int codificacion, const float vector[], int n, unsigned char destino[]){
+	size_t usados = 0;
+
+	if(codificacion == FORMATO_F32){
+		memcpy(destino, vector, sizeof(float) * n);
+		return sizeof(float) * n;
+	}
+
+	if(codificacion == FORMATO_F16){
+		float escala = 0;
+		for (int i = 0; i < n; ++i)
+		{
+			float absoluto = vector[i] < 0 ? -vector[i] : vector[i];
+			if(absoluto > escala){
+				escala = absoluto;
+			}
+		}
+		if(escala == 0){
+			escala = 1;
+		}
+		memcpy(destino, &escala, sizeof(float));
+		usados = sizeof(float);
+		for (int i = 0; i < n; ++i, usados += sizeof(uint16_t))
+		{
+			uint16_t half = float_a_half(vector[i] / escala);
+			memcpy(destino + usados, &half, sizeof(uint16_t));
+		}
+		return usados;
+	}
+
+	uint32_t anterior = 0;
+	for (int i = 0; i < n; i += 2)
+	{
+		size_t cabecera = usados++;
+		destino[cabecera] = 0;
+		for (int j = 0; j < 2 && i+j < n; ++j)
+		{
+			uint32_t bits;
+			memcpy(&bits, &vector[i+j], sizeof(bits));
+			uint32_t diferencia = bits ^ anterior;
+			anterior = bits;
+
+			int bytes = 0;
+			while(bytes < 4 && diferencia >> (8*bytes) != 0){
+				destino[usados++] = (diferencia >> (8*bytes)) & 0xff;
+				bytes++;
+			}
+			destino[cabecera] |= bytes << (4*j);
+		}
+	}
+	return usados;
+}
+
+/**
+* @brief Decodifica un vector guardado con codificar_vector().
+*
+* @param codificacion FORMATO_F32, FORMATO_F16 o FORMATO_XOR.
+* @param origen[] Bytes codificados.
+* @param disponibles Bytes disponibles en origen.
+* @param n Numero de valores.
+* @param vector[] Valores decodificados.
+* @return Bytes leidos de origen, o 0 si los datos no alcanzan o no son validos.
+*/
+static size_t
+decodificar_vector(int codificacion, const unsigned char origen[], size_t disponibles, int n, float vector[]){
+	size_t usados = 0;
+
+	if(codificacion == FORMATO_F32){
+		if(disponibles < sizeof(float) * n){
+			return 0;
+		}
+		memcpy(vector, origen, sizeof(float) * n);
+		return sizeof(float) * n;
+	}
+
+	if(codificacion == FORMATO_F16){
+		float escala;
+		if(disponibles < sizeof(float) + sizeof(uint16_t) * n){
+			return 0;
+		}
+		memcpy(&escala, origen, sizeof(float));
+		usados = sizeof(float);
+		for (int i = 0; i < n; ++i, usados += sizeof(uint16_t))
+		{
+			uint16_t half;
+			memcpy(&half, origen + usados, sizeof(uint16_t));
+			vector[i] = half_a_float(half) * escala;
+		}
+		return usados;
+	}
+
+	uint32_t anterior = 0;
+	for (int i = 0; i < n; i += 2)
+	{
+		if(usados >= disponibles){
+			return 0;
+		}
+		unsigned char cabecera = origen[usados++];
+		for (int j = 0; j < 2 && i+j < n; ++j)
+		{
+			int bytes = (cabecera >> (4*j)) & 0xf;
+			uint32_t diferencia = 0;
+			if(bytes > 4 || usados + bytes > disponibles){
+				return 0;
+			}
+			for (int b = 0; b < bytes; ++b)
+			{
+				diferencia |= (uint32_t)origen[usados++] << (8*b);
+			}
+			anterior ^= diferencia;
+			memcpy(&vector[i+j], &anterior, sizeof(float));
+		}
+	}
+	return usados;
+}
+
+/**
+* @brief Codifica los vectores vertical y horizontal de un gate, uno a continuacion del otro.
+*
+* @param formato Descripcion del bloque, con una codificacion versionada.
+* @param gate Gate con su autocorrelacion calculada.
+* @param destino[] Buffer de al menos cota_gate_formato() bytes.
+* @return Bytes escritos en destino.
+*/
+size_t
+codificar_gate(const struct Formato *formato, const struct Gate *gate, unsigned char destino[]){
+	size_t usados = codificar_vector(formato->codificacion, gate->vector_autocorr_v, formato->num_lags, destino);
+	return usados + codificar_vector(formato->codificacion, gate->vector_autocorr_h, formato->num_lags, destino + usados);
+}
+
+/**
+* @brief Completa el encabezado del formato versionado.
+*
+* @param formato Descripcion del bloque.
+* @param encabezado Encabezado a completar.
+*/
+void
+armar_encabezado_formato(const struct Formato *formato, struct EncabezadoFormato *encabezado){
+	memset(encabezado, 0, sizeof(*encabezado));
+	memcpy(encabezado->magia, FORMATO_MAGIA, sizeof(encabezado->magia));
+	encabezado->version = FORMATO_VERSION;
+	encabezado->codificacion = formato->codificacion;
+	encabezado->num_pulsos = formato->num_pulsos;
+	encabezado->num_gates = radar.num_gates;
+	encabezado->num_lags = formato->num_lags;
+}
+
+/**
+* @brief Escribe el formato original: numero de desplazamientos, y numero y vectores de cada gate.
+*
+* @param f Archivo abierto para escritura.
+* @param gates[] Gates con su autocorrelacion calculada.
+* @param num_lags Numero de desplazamientos de cada gate.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+static int
+escribir_v1(FILE *f, struct Gate gates[], int num_lags){
+	uint16_t nro_lags = num_lags;
+	uint16_t nro_gate = 0;
+	if(fwrite(&nro_lags, sizeof(uint16_t), 1, f) != 1){
+		return 1;
+	}
+
+	for (int i = 0; i < radar.num_gates; ++i, nro_gate++)
+	{
+		if(fwrite(&nro_gate, sizeof(uint16_t), 1, f) != 1
+			|| fwrite(gates[i].vector_autocorr_v, sizeof(float), num_lags, f) != (size_t)num_lags
+			|| fwrite(gates[i].vector_autocorr_h, sizeof(float), num_lags, f) != (size_t)num_lags){
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+* @brief Escribe un bloque de resultados en un archivo ya abierto, en la posicion actual.
+*
+* En el formato versionado, la tabla de offsets se escribe primero vacia y se
+* completa al final, ya que con FORMATO_XOR el tamaño de cada gate se conoce
+* recien al codificarlo.
+*
+* @param f Archivo abierto para escritura, que admita fseeko.
+* @param gates[] Gates con su autocorrelacion calculada.
+* @param formato Descripcion del bloque, armada con preparar_formato().
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+escribir_resultados(FILE *f, struct Gate gates[], const struct Formato *formato){
+	if(formato->codificacion == FORMATO_V1){
+		return escribir_v1(f, gates, formato->num_lags);
+	}
+
+	struct EncabezadoFormato encabezado;
+	uint64_t *offsets = safe_malloc(sizeof(uint64_t) * (radar.num_gates + 1));
+	unsigned char *buffer = safe_malloc(cota_gate_formato(formato));
+	off_t inicio = ftello(f);
+	int error = inicio < 0;
+
+	armar_encabezado_formato(formato, &encabezado);
+	memset(offsets, 0, sizeof(uint64_t) * (radar.num_gates + 1));
+	error = error
+		|| fwrite(&encabezado, sizeof(encabezado), 1, f) != 1
+		|| fwrite(offsets, sizeof(uint64_t), radar.num_gates + 1, f) != radar.num_gates + 1;
+
+	offsets[0] = bytes_encabezado_formato();
+	for (int i = 0; i < radar.num_gates && !error; ++i)
+	{
+		size_t bytes = codificar_gate(formato, &gates[i], buffer);
+		error = fwrite(buffer, 1, bytes, f) != bytes;
+		offsets[i+1] = offsets[i] + bytes;
+	}
+
+	error = error
+		|| fseeko(f, inicio + (off_t)sizeof(encabezado), SEEK_SET) != 0
+		|| fwrite(offsets, sizeof(uint64_t), radar.num_gates + 1, f) != radar.num_gates + 1
+		|| fseeko(f, inicio + (off_t)offsets[radar.num_gates], SEEK_SET) != 0;
+
+	free(buffer);
+	free(offsets);
+	return error;
+}
+
+/**
+* @brief Lee el formato original: numero de desplazamientos, y numero y vectores de cada gate.
+*
+* @param f Archivo abierto para lectura.
+* @param bloque Bloque a completar.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+static int
+leer_v1(FILE *f, struct BloqueResultados *bloque){
+	uint16_t nro_lags, nro_gate;
+	if(fread(&nro_lags, sizeof(uint16_t), 1, f) != 1){
+		return 1;
+	}
+	bloque->codificacion = FORMATO_V1;
+	bloque->num_pulsos = 0;
+	bloque->num_gates = radar.num_gates;
+	bloque->num_lags = nro_lags;
+	bloque->vertical = safe_malloc(sizeof(float) * bloque->num_gates * nro_lags + 1);
+	bloque->horizontal = safe_malloc(sizeof(float) * bloque->num_gates * nro_lags + 1);
+
+	for (int i = 0; i < bloque->num_gates; ++i)
+	{
+		if(fread(&nro_gate, sizeof(uint16_t), 1, f) != 1 || nro_gate != i
+			|| fread(bloque->vertical + (size_t)i*nro_lags, sizeof(float), nro_lags, f) != nro_lags
+			|| fread(bloque->horizontal + (size_t)i*nro_lags, sizeof(float), nro_lags, f) != nro_lags){
+			liberar_resultados(bloque);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+* @brief Lee un bloque de resultados en la posicion actual del archivo.
+*
+* Reconoce el formato versionado por su encabezado y decodifica cualquiera de
+* sus codificaciones; si no lo encuentra, lee el formato original con
+* radar.num_gates gates. Deja el archivo al final del bloque, por lo que los
+* bloques del modo de ventana deslizante se leen uno a continuacion del otro.
+*
+* @param f Archivo abierto para lectura, que admita fseeko.
+* @param bloque Bloque a completar. Se libera con liberar_resultados().
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+leer_resultados(FILE *f, struct BloqueResultados *bloque){
+	struct EncabezadoFormato encabezado;
+	off_t inicio = ftello(f);
+	if(inicio < 0){
+		return 1;
+	}
+	if(fread(&encabezado, sizeof(encabezado), 1, f) != 1
+		|| memcmp(encabezado.magia, FORMATO_MAGIA, sizeof(encabezado.magia)) != 0){
+		return fseeko(f, inicio, SEEK_SET) != 0 || leer_v1(f, bloque);
+	}
+	if(encabezado.version != FORMATO_VERSION || encabezado.codificacion < FORMATO_F32
+		|| encabezado.codificacion > FORMATO_XOR || encabezado.num_gates == 0 || encabezado.num_gates > MAX_GATES){
+		return 1;
+	}
+
+	size_t num_lags = encabezado.num_lags;
+	uint64_t *offsets = safe_malloc(sizeof(uint64_t) * (encabezado.num_gates + 1));
+	struct Formato formato = {encabezado.codificacion, encabezado.num_pulsos, encabezado.num_lags};
+	unsigned char *buffer = safe_malloc(cota_gate_formato(&formato) + 1);
+	int error = fread(offsets, sizeof(uint64_t), encabezado.num_gates + 1, f) != encabezado.num_gates + 1;
+
+	bloque->codificacion = encabezado.codificacion;
+	bloque->num_pulsos = encabezado.num_pulsos;
+	bloque->num_gates = encabezado.num_gates;
+	bloque->num_lags = encabezado.num_lags;
+	bloque->vertical = safe_malloc(sizeof(float) * bloque->num_gates * num_lags + 1);
+	bloque->horizontal = safe_malloc(sizeof(float) * bloque->num_gates * num_lags + 1);
+
+	for (int i = 0; i < bloque->num_gates && !error; ++i)
+	{
+		size_t bytes = offsets[i+1] - offsets[i];
+		error = offsets[i+1] < offsets[i] || bytes > cota_gate_formato(&formato)
+			|| fseeko(f, inicio + (off_t)offsets[i], SEEK_SET) != 0
+			|| fread(buffer, 1, bytes, f) != bytes;
+		if(!error){
+			size_t usados = decodificar_vector(bloque->codificacion, buffer, bytes, num_lags, bloque->vertical + i*num_lags);
+			size_t resto = usados > 0 ? decodificar_vector(bloque->codificacion, buffer + usados, bytes - usados, num_lags, bloque->horizontal + i*num_lags) : 0;
+			error = (usados == 0 || resto == 0 || usados + resto != bytes) && num_lags > 0;
+		}
+	}
+	error = error || fseeko(f, inicio + (off_t)offsets[bloque->num_gates], SEEK_SET) != 0;
+
+	free(buffer);
+	free(offsets);
+	if(error){
+		liberar_resultados(bloque);
+	}
+	return error;
+}
+
+/**
+* @brief Libera los vectores de un bloque leido con leer_resultados().
+*
+* @param bloque Bloque a liberar.
+*/
+void
+liberar_resultados(struct BloqueResultados *bloque){
+	free(bloque->vertical);
+	free(bloque->horizontal);
+	bloque->vertical = NULL;
+	bloque->horizontal = NULL;
+}
@@ -0,0 +1,1533 @@
+/** @file func_radar.c
+ *  @brief Funciones del motor de procesamiento.
+ *
+ *  Contiene las funciones que utiliza el programa para leer el archivo,
+ *  procesar los datos y guardarlos en otro archivo. Las regiones paralelas se
+ *  ejecutan con el numero de hilos elegido: con uno solo, corresponden a la
+ *  antigua ejecucion monothread.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/func_radar.h"
+#include "../include/ingesta.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+* @brief Lee del archivo el numero de pulsos que contiene, para acelerar el procesamiento.
+*
+* Lee el archivo binario, y cuenta el numero de pulsos que contiene, solo leyendo
+* el dato valid_samples de cada tabla de pulso. Además, lee el tamaño total del
+* archivo.
+*
+* @param file_name[] El nombre del archivo a leer
+* @param num_pulso Puntero para retornar el número de pulsos leídos.
+* @param size_bytes Puntero para retornar el tamaño del archivo en bytes.
+* @return 1 si hubo un error (incluido un ultimo pulso truncado), 0 caso contrario.
+*/
+int
+leer_numero_pulsos_archivo(char file_name[], int* num_pulso, uint64_t* size_bytes){
+	FILE *ptr;
+	uint16_t valid_samples = 0;
+	uint64_t posicion = 0;
+	*num_pulso = 0;
+
+	ptr=fopen(file_name,"rb");
+	if (!ptr) {
+		printf(BOLDRED"Unable to open file!\n"RESET);
+		return 1;
+	}
+
+	struct stat st;
+    // stat(file_name, &st)
+    if(fstat(fileno(ptr), &st) != 0){
+        printf(BOLDRED"Error stat\n"RESET);
+        fclose(ptr);
+        return 1;
+    }
+    printf("Tamaño del archivo "BOLDGREEN"'%s': %ld"RESET" bytes\n",file_name, st.st_size);
+    *size_bytes = st.st_size;
+
+	// if(fseek(ptr,0,SEEK_END) != 0){
+	// 	printf(BOLDRED"Error seeking file\n"RESET);
+	// 	fclose(ptr);
+	// 	return 1;
+	// }
+
+	// *size_bytes = ftell(ptr);
+	// printf("Tamaño del archivo "BOLDGREEN"'%s': %d"RESET" bytes\n",file_name, *size_bytes);
+
+	// if(fseek(ptr,0,SEEK_SET) != 0){
+	// 	printf(BOLDRED"Error seeking file\n"RESET);
+	// 	fclose(ptr);
+	// 	return 1;
+	// }
+	
+	while(posicion < *size_bytes){
+		if(fread(&valid_samples, sizeof(uint16_t), 1, ptr) != 1){
+			printf(BOLDRED"Error fread\n"RESET);
+			fclose(ptr);
+			return 1;
+		}
+		posicion += sizeof(uint16_t) + valid_samples*4*sizeof(float);
+		if(posicion > *size_bytes){
+			printf(BOLDRED"Archivo de pulsos truncado\n"RESET);
+			fclose(ptr);
+			return 1;
+		}
+		if(fseeko(ptr,valid_samples*4*sizeof(float),SEEK_CUR) != 0){
+			printf(BOLDRED"Error seeking file\n"RESET);
+			fclose(ptr);
+			return 1;
+		}
+		(*num_pulso)++;
+	}
+	
+	fclose(ptr);
+	printf("Se encontró informacion de "BOLDGREEN"%d"RESET" pulsos.\n", *num_pulso);
+	return 0;
+}
+
+
+/**
+* @brief Lee el archivo binario "pulsos.iq" y guarda su contenido en un almacen de pulsos.
+*
+* Lee el archivo binario con la salida del ADC del radar, interpreta su contenido y
+* lo guarda en un almacen de pulsos. El almacen se reserva con el tamaño justo:
+* el archivo sin los encabezados de cada pulso. Cada tabla se lee directamente
+* en su lugar de la arena, sin copias intermedias.
+*
+* Las tablas se leen en orden; la decodificacion en paralelo se hace en
+* leer_archivo_indice(), donde el lugar de cada pulso se conoce de antemano.
+*
+* @param file_name[] El nombre del archivo a leer
+* @param almacen Almacen donde guardar la información leida. Se crea en esta funcion,
+* y si no hubo errores debe liberarse con liberar_almacen().
+* @param num_pulsos Numero de pulsos del archivo, valor ya conocido.
+* @param len_file Longitud del archivo en bytes, valor ya conocido.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+leer_archivo(char file_name[], struct AlmacenPulsos *almacen, int num_pulsos, uint64_t len_file){
+	FILE *ptr;
+	uint16_t valid_samples = 0;
+	int num_pulso=0;
+
+	printf("Leyendo informacion...\n");
+
+	ptr=fopen(file_name,"rb");
+	if (!ptr) {
+		printf(BOLDRED"Unable to open file!\n"RESET);
+		return 1;
+	}
+
+	crear_almacen(almacen, num_pulsos, (len_file - num_pulsos*sizeof(uint16_t)) / sizeof(float));
+
+	while((uint64_t)ftello(ptr) != len_file){
+		//lee 1 pulso (1 tabla)
+		if(fread(&valid_samples, sizeof(uint16_t), 1, ptr) != 1
+			|| valid_samples > radar.max_muestras
+			|| ubicar_pulso(almacen, num_pulso, valid_samples) != 0
+			|| fread(tabla_pulso(almacen, num_pulso), sizeof(float), 4*valid_samples, ptr) != 4*valid_samples){
+			printf(BOLDRED"Error fread\n"RESET);
+			liberar_almacen(almacen);
+			fclose(ptr);
+			return 1;
+		}
+		num_pulso++;
+	}
+
+	fclose(ptr);
+	return 0;
+}
+
+/**
+* @brief Lee el archivo de pulsos accediendo a cada tabla a partir del indice.
+*
+* Equivalente a leer_archivo(), pero en lugar de recorrer el archivo en orden
+* toma el offset y el numero de muestras de cada pulso del indice, y lee su
+* tabla con pread.
+*
+* Como el offset de cada pulso es conocido de antemano, los pulsos se decodifican
+* en paralelo y sin depender de la posicion del archivo.
+*
+* @param file_name[] El nombre del archivo a leer
+* @param almacen Almacen donde guardar la información leida. Se crea en esta funcion,
+* y si no hubo errores debe liberarse con liberar_almacen().
+* @param indice Indice de la captura, obtenido con obtener_indice().
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+leer_archivo_indice(char file_name[], struct AlmacenPulsos *almacen, const struct IndicePulsos *indice){
+	int error = 0;
+	size_t num_floats = 0;
+
+	printf("Leyendo informacion...\n");
+
+	int fd = open(file_name, O_RDONLY);
+	if(fd < 0){
+		printf(BOLDRED"Unable to open file!\n"RESET);
+		return 1;
+	}
+
+	for (int i = 0; i < indice->num_pulsos; ++i)
+	{
+		num_floats += 4*(size_t)indice->valid_samples[i];
+	}
+	crear_almacen(almacen, indice->num_pulsos, num_floats);
+	for (int i = 0; i < indice->num_pulsos; ++i)
+	{
+		ubicar_pulso(almacen, i, indice->valid_samples[i]);
+	}
+
+	#pragma omp parallel for default(none) shared(fd, almacen, indice, radar) reduction(|:error)
+	for (int i = 0; i < indice->num_pulsos; ++i)
+	{
+		int valid_samples = indice->valid_samples[i];
+		ssize_t len_tabla = 4*valid_samples*sizeof(float);
+
+		if(valid_samples > radar.max_muestras
+			|| pread(fd, tabla_pulso(almacen, i), len_tabla, indice->offsets[i] + sizeof(uint16_t)) != len_tabla){
+			error = 1;
+		}
+	}
+
+	close(fd);
+	if(error){
+		printf(BOLDRED"Error pread\n"RESET);
+		liberar_almacen(almacen);
+	}
+	return error;
+}
+
+/**
+* @brief Calcula el valor absoluto de un número complejo.
+*
+* Calcula el módulo o valor absoluto de un número complejo, 
+* que consiste en la raíz cuadrada de la suma de los cuadrados (Pitágoras).
+*
+* @param u Componente real.
+* @param v Componente imaginaria.
+* @return result Módulo del complejo (u,v).
+*/
+float
+valor_absoluto(float u, float v){
+	return sqrt(pow(u,2) + pow(v,2));
+}
+
+/**
+* @brief Reparte los modulos de un pulso en num_gates gates y los promedia.
+*
+* A los primeros valid_samples % num_gates gates les corresponde una medicion
+* mas que al resto. Se inlinea siempre: en cada llamada de promediar_tabla()
+* con num_gates constante, el compilador reemplaza las divisiones por
+* multiplicaciones y ajusta el bucle a ese numero de gates.
+*
+* @param modulo_v[] Modulos de las muestras verticales del pulso.
+* @param modulo_h[] Modulos de las muestras horizontales del pulso.
+* @param valid_samples Numero de muestras del pulso.
+* @param num_gates Numero de gates.
+* @param promedio_v[] Promedio de los modulos verticales de cada gate.
+* @param promedio_h[] Promedio de los modulos horizontales de cada gate.
+*/
+static inline __attribute__((always_inline)) void
+repartir_gates(const float modulo_v[], const float modulo_h[], int valid_samples, int num_gates, float promedio_v[], float promedio_h[]){
+	int medicion = 0;
+	int resto = valid_samples % num_gates;
+	//calculo el resto de la division (cuantas muestras me sobran por gate)
+
+	for (int j = 0; j < num_gates; j++)
+	//en un pulso, reparte las mediciones por gate
+	{
+		float valor_abs_v = 0, valor_abs_h = 0;
+		int limite;
+		if (j >= resto) limite = valid_samples / num_gates;
+		else 			limite = (valid_samples / num_gates) + 1;
+		//calcula cuantas mediciones le tocan al gate dado
+
+		for (int k = 0; k < limite; k++, medicion++)
+		//calcula el valor absoluto de las muestras para ese gate
+		//la variable medicion no se limpia, para recorrer todas las muestras del pulso
+		{
+			valor_abs_v += modulo_v[medicion];
+			valor_abs_h += modulo_h[medicion];
+		}
+
+		promedio_v[j] = valor_abs_v/limite;
+		promedio_h[j] = valor_abs_h/limite;
+		//promedio los valores absolutos
+	}
+}
+
+/**
+* @brief Calcula los promedios y valores absolutos de un pulso, para cada gate.
+*
+* Reparte las mediciones del pulso en los radar.num_gates gates con
+* repartir_gates(). Trabaja sobre la tabla cruda, tal como se lee del archivo:
+* los modulos de las muestras se calculan por lotes con modulos_iq()
+* directamente sobre los pares I/Q intercalados, y se promedian en el mismo
+* recorrido, sin copiar antes las muestras a otro arreglo. El resultado es el
+* mismo que con valor_absoluto(). Las configuraciones habituales (250, 500 y
+* 1000 gates) usan una version de repartir_gates() especializada para ese
+* numero; el resto, la version generica.
+*
+* @param tabla Tabla del pulso: valid_samples pares I/Q de la componente vertical,
+* seguidos de los de la horizontal. Puede no estar alineada a 4 bytes.
+* @param valid_samples Numero de muestras del pulso, como maximo radar.max_muestras.
+* @param promedio_v[] Promedio de los modulos verticales de cada gate.
+* @param promedio_h[] Promedio de los modulos horizontales de cada gate.
+*/
+static void
+promediar_tabla(const void *tabla, int valid_samples, float promedio_v[], float promedio_h[]){
+	float modulo_v[radar.max_muestras], modulo_h[radar.max_muestras];
+
+	modulos_iq(tabla, valid_samples, modulo_v);
+	modulos_iq((const char *)tabla + 2*valid_samples*sizeof(float), valid_samples, modulo_h);
+	//las muestras horizontales comienzan luego de las verticales
+
+	switch(radar.num_gates){
+		case 250:
+			repartir_gates(modulo_v, modulo_h, valid_samples, 250, promedio_v, promedio_h);
+			break;
+		case 500:
+			repartir_gates(modulo_v, modulo_h, valid_samples, 500, promedio_v, promedio_h);
+			break;
+		case 1000:
+			repartir_gates(modulo_v, modulo_h, valid_samples, 1000, promedio_v, promedio_h);
+			break;
+		default:
+			repartir_gates(modulo_v, modulo_h, valid_samples, radar.num_gates, promedio_v, promedio_h);
+	}
+}
+
+/**
+* @brief Calcula los promedios de un bloque de pulsos consecutivos, y los guarda en cada gate.
+*
+* Los promedios de los pulsos del bloque se acumulan primero en una matriz local
+* de pulsos x gates. Luego se vuelcan gate por gate, de modo que cada columna
+* absol_v y absol_h recibe una corrida contigua de hasta PULSOS_POR_BLOQUE floats,
+* en lugar de un float suelto por pulso repartido en los 1000 arreglos.
+*
+* @param tablas[] Tabla cruda de cada pulso del bloque.
+* @param muestras[] Numero de muestras de cada pulso del bloque.
+* @param cantidad Numero de pulsos del bloque, como maximo PULSOS_POR_BLOQUE.
+* @param gates[] Arreglo de estructuras de tipo gate, donde guardar los promedios y modulos calculados.
+* @param inicio Posicion del primer pulso del bloque en la captura.
+*/
+static void
+promediar_bloque(const void *tablas[], const int muestras[], int cantidad, struct Gate gates[], int inicio){
+	float promedio_v[PULSOS_POR_BLOQUE][radar.num_gates], promedio_h[PULSOS_POR_BLOQUE][radar.num_gates];
+
+	for (int p = 0; p < cantidad; ++p)
+	{
+		promediar_tabla(tablas[p], muestras[p], promedio_v[p], promedio_h[p]);
+	}
+
+	for (int j = 0; j < radar.num_gates; j++)
+	{
+		for (int p = 0; p < cantidad; ++p)
+		{
+			gates[j].absol_v[inicio+p] = promedio_v[p][j];
+			gates[j].absol_h[inicio+p] = promedio_h[p][j];
+		}
+	}
+}
+
+/**
+* @brief Calcula promedios de mediciones en cada gate, y el valor absoluto de las mismas.
+*
+* Dado un pulso, y una cantidad de mediciones asociada, distribuye las mismas en los gates
+* que discrimina el radar. Calcula el valor promedio de las mediciones por gate, y luego 
+* el valor absoluto de cada promedio.
+*
+* Se acelera implementando un parallel for en el bucle más externo, que itera sobre
+* el numero de pulsos en el archivo. Por lo tanto, se van calculando los promedios
+* y el valor absoluto de las mediciones de cada pulso en paralelo, en función del
+* número de hilos utilizado para ejecutar el programa.
+*
+* @param almacen Almacen con los pulsos leidos.
+* @param gates[] Arreglo de estructuras de tipo gate, donde guardar los promedios y modulos calculados.
+*/
+void
+promedio_y_valor_absoluto(const struct AlmacenPulsos *almacen, struct Gate gates[]){
+	printf("Calculando valor absoluto y promedio de las mediciones...\n");
+
+	#pragma omp parallel for default(none) shared(almacen, gates)
+	for (int inicio = 0; inicio < almacen->num_pulsos; inicio += PULSOS_POR_BLOQUE)
+	//itera sobre bloques de pulsos para repartir mediciones en cada gate
+	{
+		const void *tablas[PULSOS_POR_BLOQUE];
+		int cantidad = almacen->num_pulsos - inicio < PULSOS_POR_BLOQUE ? almacen->num_pulsos - inicio : PULSOS_POR_BLOQUE;
+
+		for (int p = 0; p < cantidad; ++p)
+		{
+			tablas[p] = tabla_pulso(almacen, inicio+p);
+		}
+		promediar_bloque(tablas, &almacen->valid_samples[inicio], cantidad, gates, inicio);
+	}
+}
+
+/**
+* @brief Calcula promedios y valores absolutos por gate a partir de una captura mapeada.
+*
+* Equivalente a promedio_y_valor_absoluto(), pero lee las muestras directamente
+* de las vistas de la captura mapeada en memoria, sin copiarlas antes a un
+* almacen de pulsos.
+*
+* Se paraleliza sobre los pulsos, igual que en promedio_y_valor_absoluto().
+*
+* @param captura Captura mapeada con abrir_captura().
+* @param gates[] Arreglo de estructuras de tipo gate, donde guardar los promedios y modulos calculados.
+*/
+void
+promedio_y_valor_absoluto_captura(const struct Captura *captura, struct Gate gates[]){
+	printf("Calculando valor absoluto y promedio de las mediciones...\n");
+
+	#pragma omp parallel for default(none) shared(captura, gates)
+	for (int inicio = 0; inicio < captura->num_pulsos; inicio += PULSOS_POR_BLOQUE)
+	{
+		const void *tablas[PULSOS_POR_BLOQUE];
+		int muestras[PULSOS_POR_BLOQUE];
+		int cantidad = captura->num_pulsos - inicio < PULSOS_POR_BLOQUE ? captura->num_pulsos - inicio : PULSOS_POR_BLOQUE;
+
+		for (int p = 0; p < cantidad; ++p)
+		{
+			tablas[p] = captura->pulsos[inicio+p].datos;
+			muestras[p] = captura->pulsos[inicio+p].valid_samples;
+		}
+		promediar_bloque(tablas, muestras, cantidad, gates, inicio);
+	}
+}
+
+/**
+* @brief Procesa el archivo de pulsos en flujo, sin guardar todos los pulsos en memoria.
+*
+* Lee los pulsos en bloques de BLOQUE_FLUJO tablas crudas, calcula sus promedios
+* y valores absolutos en cada gate, y reutiliza el bloque para los siguientes.
+* La memoria utilizada queda determinada por la matriz de gates, y no por el
+* tamaño de la captura.
+*
+* La lectura de cada bloque es secuencial; el calculo de los pulsos del bloque,
+* directamente sobre sus tablas crudas, se reparte entre los hilos de a
+* PULSOS_POR_BLOQUE pulsos.
+*
+* Procesa solo los num_pulsos pulsos que comienzan en offset, y guarda sus
+* promedios a partir de la fila primer_pulso de cada gate. Con offset y
+* primer_pulso en 0 procesa la captura completa; el modo incremental lo usa
+* para procesar solo los pulsos agregados al final.
+*
+* @param file_name[] El nombre del archivo a leer.
+* @param gates[] Arreglo de estructuras de tipo gate, ya inicializado para primer_pulso+num_pulsos pulsos.
+* @param offset Posicion en bytes del primer pulso a procesar.
+* @param primer_pulso Numero del primer pulso a procesar dentro de la captura.
+* @param num_pulsos Numero de pulsos a procesar.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+procesar_archivo_desde(char file_name[], struct Gate gates[], uint64_t offset, int primer_pulso, int num_pulsos){
+	FILE *ptr;
+	uint16_t valid_samples;
+	int error = 0;
+
+	printf("Procesando pulsos en flujo...\n");
+
+	ptr=fopen(file_name,"rb");
+	if (!ptr) {
+		printf(BOLDRED"Unable to open file!\n"RESET);
+		return 1;
+	}
+	if(fseeko(ptr, offset, SEEK_SET) != 0){
+		printf(BOLDRED"Error seeking file\n"RESET);
+		fclose(ptr);
+		return 1;
+	}
+	int total = primer_pulso + num_pulsos;
+	//fila siguiente al ultimo pulso a procesar
+
+	float *crudo = safe_malloc(sizeof(float) * 4*radar.max_muestras * BLOQUE_FLUJO);
+	int muestras[BLOQUE_FLUJO];
+
+	for (int inicio = primer_pulso; inicio < total; inicio += BLOQUE_FLUJO)
+	{
+		int fin = inicio + BLOQUE_FLUJO < total ? inicio + BLOQUE_FLUJO : total;
+
+		for (int i = inicio; i < fin; ++i)
+		{
+			if(fread(&valid_samples, sizeof(uint16_t), 1, ptr) != 1
+				|| valid_samples > radar.max_muestras
+				|| fread(&crudo[4*radar.max_muestras * (i-inicio)], sizeof(float), 4*valid_samples, ptr) != 4*valid_samples){
+				error = 1;
+				break;
+			}
+			muestras[i-inicio] = valid_samples;
+		}
+		if(error){
+			printf(BOLDRED"Error fread\n"RESET);
+			break;
+		}
+
+		#pragma omp parallel for default(none) shared(crudo, muestras, gates, inicio, fin, radar)
+		for (int bloque = inicio; bloque < fin; bloque += PULSOS_POR_BLOQUE)
+		{
+			const void *tablas[PULSOS_POR_BLOQUE];
+			int cantidad = fin - bloque < PULSOS_POR_BLOQUE ? fin - bloque : PULSOS_POR_BLOQUE;
+
+			for (int p = 0; p < cantidad; ++p)
+			{
+				tablas[p] = &crudo[4*radar.max_muestras * (bloque-inicio+p)];
+			}
+			promediar_bloque(tablas, &muestras[bloque-inicio], cantidad, gates, bloque);
+		}
+	}
+
+	free(crudo);
+	fclose(ptr);
+	return error;
+}
+
+/**
+* @brief Procesa la captura completa en flujo, con procesar_archivo_desde().
+*
+* @param file_name[] El nombre del archivo a leer.
+* @param gates[] Arreglo de estructuras de tipo gate, ya inicializado para num_pulsos pulsos.
+* @param num_pulsos Numero de pulsos del archivo.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+procesar_archivo_flujo(char file_name[], struct Gate gates[], int num_pulsos){
+	return procesar_archivo_desde(file_name, gates, 0, 0, num_pulsos);
+}
+
+/**
+* @brief Procesa una celda del anillo: promedia sus pulsos y los guarda en cada gate.
+*
+* @param celda Celda tomada con tomar_celda().
+* @param gates[] Arreglo de estructuras de tipo gate, donde guardar los promedios.
+*/
+static void
+consumir_celda(const struct CeldaAnillo *celda, struct Gate gates[]){
+	const void *tablas[PULSOS_POR_BLOQUE];
+	for (int p = 0; p < celda->cantidad; ++p)
+	{
+		tablas[p] = &celda->crudo[4*radar.max_muestras * p];
+	}
+	promediar_bloque(tablas, celda->muestras, celda->cantidad, gates, celda->inicio);
+}
+
+/**
+* @brief Procesa el archivo de pulsos con un hilo lector y los demas calculando a la vez.
+*
+* A diferencia de procesar_archivo_flujo(), donde los hilos esperan a que se lea
+* cada bloque, aqui el hilo 0 del equipo solo lee: llena las celdas de un
+* anillo sin locks con bloques de PULSOS_POR_BLOQUE pulsos crudos, mientras el
+* resto de los hilos las toman, calculan los promedios y los guardan en los
+* gates. El tiempo total tiende al mayor entre la lectura y el calculo, y no a
+* su suma. Cada celda cubre una corrida alineada de PULSOS_POR_BLOQUE floats
+* de cada gate, por lo que los hilos nunca escriben la misma linea de cache.
+*
+* Con un solo hilo, el lector procesa cada celda apenas la publica.
+*
+* @param file_name[] El nombre del archivo a leer.
+* @param gates[] Arreglo de estructuras de tipo gate, ya inicializado para num_pulsos pulsos.
+* @param num_pulsos Numero de pulsos del archivo.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+procesar_archivo_pipeline(char file_name[], struct Gate gates[], int num_pulsos){
+	struct Anillo anillo;
+	int error = 0;
+	size_t total = (num_pulsos + PULSOS_POR_BLOQUE - 1) / PULSOS_POR_BLOQUE;
+
+	printf("Procesando pulsos con un hilo lector...\n");
+
+	FILE *ptr = fopen(file_name, "rb");
+	if (!ptr) {
+		printf(BOLDRED"Unable to open file!\n"RESET);
+		return 1;
+	}
+	crear_anillo(&anillo, omp_get_max_threads() - 1);
+
+	#pragma omp parallel default(none) shared(ptr, anillo, gates, num_pulsos, total, error, radar)
+	{
+		if(omp_get_thread_num() == 0){
+			uint16_t valid_samples;
+			int solo = omp_get_num_threads() == 1;
+
+			for (size_t b = 0; b < total && !error; ++b)
+			{
+				struct CeldaAnillo *celda = reservar_celda(&anillo);
+				celda->inicio = b * PULSOS_POR_BLOQUE;
+				celda->cantidad = num_pulsos - celda->inicio < PULSOS_POR_BLOQUE ? num_pulsos - celda->inicio : PULSOS_POR_BLOQUE;
+
+				for (int p = 0; p < celda->cantidad; ++p)
+				{
+					if(fread(&valid_samples, sizeof(uint16_t), 1, ptr) != 1
+						|| valid_samples > radar.max_muestras
+						|| fread(&celda->crudo[4*radar.max_muestras * p], sizeof(float), 4*valid_samples, ptr) != 4*valid_samples){
+						error = 1;
+						cancelar_anillo(&anillo);
+						//libera a los consumidores que esperan celdas
+						break;
+					}
+					celda->muestras[p] = valid_samples;
+				}
+				if(!error){
+					publicar_celda(&anillo, celda);
+				}
+				if(solo && (celda = tomar_celda(&anillo, total)) != NULL){
+					consumir_celda(celda, gates);
+					devolver_celda(&anillo, celda);
+				}
+			}
+		}
+		else{
+			struct CeldaAnillo *celda;
+			while((celda = tomar_celda(&anillo, total)) != NULL){
+				consumir_celda(celda, gates);
+				devolver_celda(&anillo, celda);
+			}
+		}
+	}
+
+	if(error){
+		printf(BOLDRED"Error fread\n"RESET);
+	}
+	liberar_anillo(&anillo);
+	fclose(ptr);
+	return error;
+}
+
+/**
+* @brief Prepara los gates para el modo incremental.
+*
+* Carga el estado guardado de la captura, cuenta los pulsos agregados desde la
+* ultima ejecucion, inicializa los gates para el total de pulsos, restaura las
+* columnas ya calculadas y procesa en flujo solo los pulsos nuevos.
+*
+* @param file_name[] El nombre de la captura.
+* @param gates[] Arreglo de estructuras de tipo gate, sin inicializar.
+* @param max_lags Opcion -l (L+1), o 0 si no se limita.
+* @param estado Estructura donde cargar el estado, con el offset ya actualizado al
+* final de los pulsos nuevos. Debe liberarse con liberar_estado().
+* @param num_pulsos Puntero para retornar el numero total de pulsos.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+leer_archivo_incremental(char file_name[], struct Gate gates[], int max_lags, struct EstadoIncremental *estado, int *num_pulsos){
+	int nuevos;
+	uint64_t fin;
+
+	cargar_estado(file_name, max_lags, estado);
+	if(contar_pulsos_nuevos(file_name, estado->offset, &nuevos, &fin) != 0){
+		liberar_estado(estado);
+		return 1;
+	}
+
+	*num_pulsos = estado->num_pulsos + nuevos;
+	initialize_gates(gates, *num_pulsos);
+	restaurar_columnas(estado, gates);
+	if(procesar_archivo_desde(file_name, gates, estado->offset, estado->num_pulsos, nuevos) != 0){
+		liberar_estado(estado);
+		return 1;
+	}
+
+	estado->offset = fin;
+	return 0;
+}
+
+/**
+* @brief Calcula la autocorrelacion normalizada de un vector dado.
+*
+* Calcula la autocorrelacion del vector dada su longitud, y devuelve el
+* resultado en otro vector de la misma longitud.
+* Aprovechando la propiedad de simetría, se devuelve un vector de igual
+* longitud que el vector de entrada, siendo cada valor en el mismo la correlacion
+* sobre si mismo, variando el desplazamiento.
+* Para normalizarlo, se dividen los resultados por el numero de elementos del vector.
+* Si solo interesan los primeros desplazamientos, el costo baja de O(len^2) a
+* O(len*num_lags).
+*
+* @param vector[] Vector a calcular la autocorrelacion.
+* @param len Longitud del vector.
+* @param num_lags Numero de desplazamientos a calcular, de 0 a num_lags-1. Como maximo len.
+* @param resultado[] Resultado del calculo.
+*/
+void
+autocorrelacion(float vector[], int len, int num_lags, float resultado[]){
+	for (int i = 0; i < num_lags; ++i)
+	{
+		float suma = 0;
+		for (int j = 0; j < len-i; ++j)
+		{
+			suma += vector[j] * vector[j+i];
+		}
+		resultado[i] = suma/len;
+		//valor normalizado
+	}
+}
+
+/**
+* @brief Dado un conjunto de gates, calcula la autocorrelacion normalizada de cada uno.
+*
+* Calcula la autocorrelacion de cada vector columna gate, y guarda en ese gate el vector resultado.
+*
+* Se paraleliza el bucle for, permitiendo calcular la autocorrelacion de cada gate por separado.
+*
+* @param gates[] Arreglo de estructuras de tipo gate, de donde saca el vector de modulos, y donde 
+* guarda la correlacion calculada.
+* @param num_pulsos Numero de pulsos en cada gate.
+* @param num_lags Numero de desplazamientos a calcular, obtenido con lags_calculados().
+* @param salida Salida posicional donde escribir cada gate apenas se calcula, o NULL.
+*/
+void
+calcular_autocorrelacion(struct Gate gates[], int num_pulsos, int num_lags, struct Salida *salida){
+	printf("Calculando autocorrelacion de cada gate...\n");
+	
+	#pragma omp parallel for schedule(static) default(none) shared(num_pulsos, num_lags, gates, salida, radar)
+	for (int i = 0; i < radar.num_gates; ++i)
+	{	
+		autocorrelacion(gates[i].absol_v, num_pulsos, num_lags, gates[i].vector_autocorr_v);
+		autocorrelacion(gates[i].absol_h, num_pulsos, num_lags, gates[i].vector_autocorr_h);
+		if(salida != NULL){
+			escribir_gate_salida(salida, &gates[i], i);
+		}
+	}
+}
+
+/**
+* @brief Dado un conjunto de gates, calcula la autocorrelacion normalizada de cada uno con kernels SIMD.
+*
+* Alternativa a calcular_autocorrelacion() que usa el kernel vectorizado elegido
+* por inicializar_simd(), que debe haberse llamado antes.
+*
+* Se paraleliza el bucle for, igual que en calcular_autocorrelacion().
+*
+* @param gates[] Arreglo de estructuras de tipo gate, de donde saca el vector de modulos, y donde
+* guarda la correlacion calculada.
+* @param num_pulsos Numero de pulsos en cada gate.
+* @param num_lags Numero de desplazamientos a calcular, obtenido con lags_calculados().
+* @param salida Salida posicional donde escribir cada gate apenas se calcula, o NULL.
+*/
+void
+calcular_autocorrelacion_simd(struct Gate gates[], int num_pulsos, int num_lags, struct Salida *salida){
+	printf("Calculando autocorrelacion de cada gate (SIMD)...\n");
+
+	#pragma omp parallel for schedule(static) default(none) shared(num_pulsos, num_lags, gates, salida, radar)
+	for (int i = 0; i < radar.num_gates; ++i)
+	{
+		autocorrelacion_simd(gates[i].absol_v, num_pulsos, num_lags, gates[i].vector_autocorr_v);
+		autocorrelacion_simd(gates[i].absol_h, num_pulsos, num_lags, gates[i].vector_autocorr_h);
+		if(salida != NULL){
+			escribir_gate_salida(salida, &gates[i], i);
+		}
+	}
+}
+
+/**
+* @brief Indica si todos los valores de un vector son finitos.
+*
+* @param vector[] Vector a revisar.
+* @param len Longitud del vector.
+* @return 1 si no hay NaN ni infinitos, 0 caso contrario.
+*/
+static int
+vector_finito(const float vector[], int len){
+	for (int j = 0; j < len; ++j)
+	{
+		if(!isfinite(vector[j])){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+* @brief Dado un conjunto de gates, calcula la autocorrelacion normalizada de cada uno por FFT.
+*
+* Alternativa a calcular_autocorrelacion() que usa el motor FFT. El plan se
+* crea una vez y se reutiliza para todos los gates. El resultado coincide con
+* el calculo directo dentro de FFT_TOLERANCIA.
+*
+* Un solo valor no finito en la columna de un gate se propagaria por las dos
+* transformadas a todos sus desplazamientos, por lo que esos gates se
+* calculan con autocorrelacion(), igual que el motor directo.
+*
+* Se paraleliza sobre los gates; cada hilo usa su propio vector de trabajo.
+*
+* @param gates[] Arreglo de estructuras de tipo gate, de donde saca el vector de modulos, y donde
+* guarda la correlacion calculada.
+* @param num_pulsos Numero de pulsos en cada gate.
+* @param num_lags Numero de desplazamientos a calcular, obtenido con lags_calculados().
+* @param salida Salida posicional donde escribir cada gate apenas se calcula, o NULL.
+*/
+void
+calcular_autocorrelacion_fft(struct Gate gates[], int num_pulsos, int num_lags, struct Salida *salida){
+	struct PlanFFT plan;
+
+	printf("Calculando autocorrelacion de cada gate (FFT)...\n");
+	crear_plan_fft(&plan, num_pulsos, num_lags);
+
+	#pragma omp parallel default(none) shared(plan, num_pulsos, num_lags, gates, salida, radar)
+	{
+		double *trabajo = crear_trabajo_fft(&plan);
+		#pragma omp for schedule(static)
+		for (int i = 0; i < radar.num_gates; ++i)
+		{
+			if(vector_finito(gates[i].absol_v, num_pulsos) && vector_finito(gates[i].absol_h, num_pulsos)){
+				autocorrelacion_fft(&plan, gates[i].absol_v, gates[i].absol_h,
+					gates[i].vector_autocorr_v, gates[i].vector_autocorr_h, trabajo);
+			}
+			else{
+				autocorrelacion(gates[i].absol_v, num_pulsos, num_lags, gates[i].vector_autocorr_v);
+				autocorrelacion(gates[i].absol_h, num_pulsos, num_lags, gates[i].vector_autocorr_h);
+			}
+			if(salida != NULL){
+				escribir_gate_salida(salida, &gates[i], i);
+			}
+		}
+		free(trabajo);
+	}
+
+	destruir_plan_fft(&plan);
+}
+
+/**
+* @brief Actualiza la autocorrelacion de cada gate con los pulsos nuevos.
+*
+* Parte de las sumas sin normalizar guardadas en el estado, les suma el aporte
+* de los pulsos agregados con acumular_lags(), y normaliza por el numero total
+* de pulsos. Las sumas del estado se reemplazan por las actualizadas, para
+* guardarlas con guardar_estado(). Se calculan
+* lags_calculados(num_pulsos, estado->max_lags) desplazamientos.
+*
+* Se paraleliza sobre los gates, igual que en calcular_autocorrelacion().
+*
+* @param gates[] Arreglo de estructuras de tipo gate, con las columnas de modulos
+* de todos los pulsos, y donde guarda la correlacion calculada.
+* @param estado Estado cargado con leer_archivo_incremental().
+* @param num_pulsos Numero total de pulsos en cada gate.
+* @param salida Salida posicional donde escribir cada gate apenas se calcula, o NULL.
+*/
+void
+calcular_autocorrelacion_incremental(struct Gate gates[], struct EstadoIncremental *estado, int num_pulsos, struct Salida *salida){
+	size_t por_gate = lags_calculados(num_pulsos, estado->max_lags);
+	size_t previos = lags_calculados(estado->num_pulsos, estado->max_lags);
+	double *sumas_v = safe_malloc(sizeof(double) * radar.num_gates * (por_gate > 0 ? por_gate : 1));
+	double *sumas_h = safe_malloc(sizeof(double) * radar.num_gates * (por_gate > 0 ? por_gate : 1));
+
+	printf("Actualizando autocorrelacion de cada gate con "BOLDGREEN"%d"RESET" pulsos nuevos...\n", num_pulsos - estado->num_pulsos);
+
+	#pragma omp parallel for schedule(static) default(none) shared(num_pulsos, por_gate, previos, gates, estado, sumas_v, sumas_h, salida, radar)
+	for (int i = 0; i < radar.num_gates; ++i)
+	{
+		double *suma_v = &sumas_v[i*por_gate], *suma_h = &sumas_h[i*por_gate];
+
+		memcpy(suma_v, &estado->sumas_v[i*previos], sizeof(double) * previos);
+		memcpy(suma_h, &estado->sumas_h[i*previos], sizeof(double) * previos);
+		memset(&suma_v[previos], 0, sizeof(double) * (por_gate - previos));
+		memset(&suma_h[previos], 0, sizeof(double) * (por_gate - previos));
+
+		acumular_lags(gates[i].absol_v, estado->num_pulsos, num_pulsos, por_gate, suma_v);
+		acumular_lags(gates[i].absol_h, estado->num_pulsos, num_pulsos, por_gate, suma_h);
+
+		for (int j = 0; j < (int)por_gate; ++j)
+		{
+			gates[i].vector_autocorr_v[j] = suma_v[j] / num_pulsos;
+			gates[i].vector_autocorr_h[j] = suma_h[j] / num_pulsos;
+		}
+		if(salida != NULL){
+			escribir_gate_salida(salida, &gates[i], i);
+		}
+	}
+
+	free(estado->sumas_v);
+	free(estado->sumas_h);
+	estado->sumas_v = sumas_v;
+	estado->sumas_h = sumas_h;
+	estado->num_pulsos = num_pulsos;
+}
+
+typedef void (*MotorAutocorr)(struct Gate gates[], int num_pulsos, int num_lags, struct Salida *salida);
+/*!< Firma comun de los motores de autocorrelacion. */
+
+static const MotorAutocorr registro_motores[] = {
+	[MOTOR_DIRECTO] = calcular_autocorrelacion,
+	[MOTOR_FFT] = calcular_autocorrelacion_fft,
+	[MOTOR_SIMD] = calcular_autocorrelacion_simd,
+};
+/*!< Implementacion de cada motor de autocorrelacion, indexada por MOTOR_*. */
+
+/**
+* @brief Calcula la autocorrelacion de todos los gates con el motor elegido.
+*
+* Con MOTOR_AUTO, el motor se elige con elegir_motor() segun el numero de
+* pulsos y de desplazamientos, por lo que en el modo por lotes puede variar
+* de una captura a otra.
+*
+* @param gates[] Arreglo de estructuras de tipo gate, con las columnas de modulos
+* de todos los pulsos, y donde guarda la correlacion calculada.
+* @param motor Motor de autocorrelacion (uno de los MOTOR_*).
+* @param num_pulsos Numero de pulsos en cada gate.
+* @param num_lags Numero de desplazamientos a calcular, entre 1 y num_pulsos.
+* @param salida Salida posicional donde escribir cada gate apenas se calcula, o NULL.
+*/
+void
+calcular_autocorrelacion_motor(struct Gate gates[], int motor, int num_pulsos, int num_lags, struct Salida *salida){
+	int elegido = elegir_motor(motor, num_pulsos, num_lags);
+	if(motor == MOTOR_AUTO){
+		printf("Motor de autocorrelacion: "BOLDGREEN"%s"RESET"\n", nombre_motor(elegido));
+	}
+	registro_motores[elegido](gates, num_pulsos, num_lags, salida);
+}
+
+/**
+* @brief Guarda en un archivo binario el resultado de los calculos.
+*
+* Guarda en un archivo binario los valores calculados, con la siguiente estructura:
+* numero de pulsos -> uint16_t
+* 	numero de gate actual (0) -> uint16_t
+* 	correlacion[0] -> float
+* 	correlacion[1] -> float
+* 	...
+* 	correlacion[numero de pulsos] -> float
+*	
+*	...
+*	numero de gate actual (500) -> uint16_t
+*	correlacion[0] ->float
+*	...
+*	correlacion[numero de pulsos] -> float
+*
+* Dicho de otra manera, los datos se estructuran en una matriz, donde el eje x son
+* los gates, y el eje y contiene el vector de autocorrelacion de cada gate.
+* Se guarda el vector correspondiente al gate 0, luego el vector del gate 1, hasta el último.
+* Con la opcion -l el numero guardado es el de desplazamientos calculados, L+1,
+* en lugar del numero de pulsos.
+*
+* Con la opcion -e se usa en cambio el formato versionado descripto en
+* formato.h, que guarda los numeros en 32 bits y puede codificar los vectores.
+*
+* @param gates[] Arreglo de estructuras de tipo gate, que contiene los resultados de la correlacion a guardar.
+* @param filename[] Nombre del archivo donde se quieren guardar los datos.
+* @param formato Formato del archivo, armado con preparar_formato().
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+guardar_archivo(struct Gate gates[], char filename[], const struct Formato *formato){
+	printf("Guardando resultados...\n");
+	FILE* f = fopen(filename,"wb");
+	if(!f){
+		printf(BOLDRED"Error abriendo archivo para escritura\n"RESET);
+		return 1;
+	}
+	if(escribir_resultados(f, gates, formato) != 0){
+		printf(BOLDRED"Error fwrite\n"RESET);
+		fclose(f);
+		return 1;
+	}
+
+	fclose(f);
+	return 0;
+}
+
+/**
+* @brief Procesa un flujo de pulsos en tiempo real, con una ventana deslizante.
+*
+* Lee los pulsos de entrada (la entrada estandar, o un FIFO redirigido a ella)
+* a medida que llegan, sin conocer de antemano su numero ni el tamaño del
+* flujo. Mantiene para cada gate la autocorrelacion de los ultimos capacidad
+* pulsos, y cada paso pulsos escribe un bloque de resultados en filename, con
+* el formato de guardar_archivo(), y lo vuelca al disco. Al terminar el flujo
+* escribe un ultimo bloque si quedaron pulsos sin emitir.
+*
+* El trabajo por bloque es O(paso * capacidad) por gate, independiente de
+* cuantos pulsos se hayan recibido antes, por lo que la latencia de cada
+* bloque queda acotada. La latencia de un bloque se mide desde la llegada de
+* su pulso mas antiguo (el primero recibido despues del bloque anterior)
+* hasta que el bloque se vuelca al disco: incluye la espera y la lectura de
+* los demas pulsos del bloque, ademas del calculo. Para que la llegada de
+* cada pulso se registre cuando lo entrega el sistema, y no cuando se
+* consume del buffer de stdio, la entrada se lee sin buffer. Se informa la
+* latencia maxima medida y, si se fijo un plazo, los bloques que lo superaron.
+*
+* El calculo de los promedios se reparte entre los hilos por pulso, y la
+* actualizacion de las ventanas por gate, con el mismo reparto estatico que el
+* resto de los calculos por gate.
+*
+* @param entrada Flujo de pulsos, con el mismo formato que el archivo de pulsos.
+* @param gates[] Arreglo de estructuras de tipo gate, inicializado para capacidad pulsos.
+* @param capacidad Numero de pulsos de la ventana.
+* @param paso Numero de pulsos entre dos bloques de resultados.
+* @param plazo Latencia maxima admitida por bloque en segundos (opcion -d), o 0 para no controlarla.
+* @param max_lags Opcion -l (L+1), o 0 para calcular todos los desplazamientos.
+* @param codificacion Formato de los bloques, elegido con la opcion -e.
+* @param filename[] Nombre del archivo donde escribir los bloques.
+* @return 1 si hubo un error o algun bloque supero el plazo, 0 caso contrario.
+*/
+int
+procesar_ventana(FILE *entrada, struct Gate gates[], int capacidad, int paso, double plazo, int max_lags, int codificacion, char filename[]){
+	struct Ventana ventana;
+	uint16_t valid_samples;
+	int error = 0, pendientes = 0, bloques = 0, fin_flujo = 0, fuera_de_plazo = 0;
+	double latencia_maxima = 0, llegada_bloque = 0;
+
+	setvbuf(entrada, NULL, _IONBF, 0);
+
+	FILE *f = fopen(filename, "wb");
+	if(!f){
+		printf(BOLDRED"Error abriendo archivo para escritura\n"RESET);
+		return 1;
+	}
+
+	printf("Procesando flujo con ventana de "BOLDGREEN"%d"RESET" pulsos, un bloque cada "BOLDGREEN"%d"RESET"...\n", capacidad, paso);
+
+	float *crudo = safe_malloc(sizeof(float) * 4*radar.max_muestras * BLOQUE_FLUJO);
+	float (*promedio_v)[radar.num_gates] = safe_malloc(sizeof(float) * radar.num_gates * BLOQUE_FLUJO);
+	float (*promedio_h)[radar.num_gates] = safe_malloc(sizeof(float) * radar.num_gates * BLOQUE_FLUJO);
+	int muestras[BLOQUE_FLUJO];
+	crear_ventana(&ventana, capacidad, max_lags);
+
+	while(!fin_flujo)
+	{
+		int cantidad = 0;
+		int maximo = paso - pendientes < BLOQUE_FLUJO ? paso - pendientes : BLOQUE_FLUJO;
+
+		for (; cantidad < maximo; ++cantidad)
+		{
+			if(fread(&valid_samples, sizeof(uint16_t), 1, entrada) != 1){
+				fin_flujo = 1;
+				break;
+			}
+			if(pendientes + cantidad == 0){
+				llegada_bloque = omp_get_wtime();
+			}
+			if(valid_samples > radar.max_muestras
+				|| fread(&crudo[4*radar.max_muestras * cantidad], sizeof(float), 4*valid_samples, entrada) != 4*valid_samples){
+				error = 1;
+				break;
+			}
+			muestras[cantidad] = valid_samples;
+		}
+		if(error){
+			printf(BOLDRED"Error fread\n"RESET);
+			break;
+		}
+
+		#pragma omp parallel for default(none) shared(crudo, muestras, cantidad, promedio_v, promedio_h, radar)
+		for (int p = 0; p < cantidad; ++p)
+		{
+			promediar_tabla(&crudo[4*radar.max_muestras * p], muestras[p], promedio_v[p], promedio_h[p]);
+		}
+
+		#pragma omp parallel for schedule(static) default(none) shared(ventana, gates, cantidad, promedio_v, promedio_h, radar)
+		for (int j = 0; j < radar.num_gates; ++j)
+		{
+			for (int p = 0; p < cantidad; ++p)
+			{
+				desplazar_gate(&ventana, &gates[j], j, ventana.total + p, promedio_v[p][j], promedio_h[p][j]);
+			}
+		}
+		ventana.total += cantidad;
+		pendientes += cantidad;
+
+		if(pendientes == paso || (fin_flujo && pendientes > 0)){
+			#pragma omp parallel for schedule(static) default(none) shared(ventana, gates, radar)
+			for (int j = 0; j < radar.num_gates; ++j)
+			{
+				normalizar_gate(&ventana, &gates[j], j);
+			}
+			struct Formato formato;
+			preparar_formato(&formato, codificacion, pulsos_en_ventana(&ventana), lags_en_ventana(&ventana));
+			if(escribir_resultados(f, gates, &formato) != 0 || fflush(f) != 0){
+				printf(BOLDRED"Error fwrite\n"RESET);
+				error = 1;
+				break;
+			}
+			double latencia = omp_get_wtime() - llegada_bloque;
+			if(latencia > latencia_maxima) latencia_maxima = latencia;
+			if(plazo > 0 && latencia > plazo){
+				printf(BOLDYELLOW"Bloque %d: latencia de %f segundos, supera el plazo de %f\n"RESET, bloques, latencia, plazo);
+				fuera_de_plazo++;
+			}
+			pendientes = 0;
+			bloques++;
+		}
+	}
+
+	printf("Pulsos recibidos: "BOLDGREEN"%ld"RESET", bloques emitidos: "BOLDGREEN"%d"RESET", latencia maxima: "BOLDGREEN"%f"RESET" segundos\n",
+		ventana.total, bloques, latencia_maxima);
+	if(plazo > 0){
+		printf("Bloques fuera del plazo de %f segundos: %s%d"RESET"\n", plazo, fuera_de_plazo ? BOLDRED : BOLDGREEN, fuera_de_plazo);
+		error |= fuera_de_plazo > 0;
+	}
+
+	liberar_ventana(&ventana);
+	free(promedio_h);
+	free(promedio_v);
+	free(crudo);
+	fclose(f);
+	return error;
+}
+
+/**
+* @brief Lee una captura del lote en un almacen.
+*
+* Se ejecuta en un hilo propio, mientras el equipo de hilos de OpenMP calcula
+* la captura anterior. Las regiones paralelas de la lectura (con -i) usan un
+* solo hilo, para no competir con ese equipo.
+*
+* Como dos capturas pueden estar en memoria a la vez, una captura que no
+* entra_en_memoria() se mapea con abrir_captura(), igual que en
+* cargar_captura(). Si no puede leerse, se marca el error y el lote continua.
+*
+* @param arg Puntero a la struct LecturaLote a completar.
+* @return NULL.
+*/
+static void *
+leer_captura_lote(void *arg){
+	struct LecturaLote *lectura = arg;
+	struct stat st;
+	omp_set_num_threads(1);
+
+	lectura->mapeada = stat(lectura->ruta, &st) == 0 && !entra_en_memoria(st.st_size);
+	if(lectura->mapeada){
+		struct IndicePulsos indice = {0};
+		printf(BOLDYELLOW"La captura '%s' ocupa mas de 1/%d de la memoria fisica, se mapea en lugar de leerla\n"RESET,
+			lectura->ruta, INGESTA_FRACCION_MEMORIA);
+		lectura->error = (lectura->indice_flag && obtener_indice(lectura->ruta, &indice) != 0)
+			|| abrir_captura(lectura->ruta, lectura->indice_flag ? &indice : NULL, &lectura->captura) != 0;
+		lectura->num_pulsos = lectura->error ? 0 : lectura->captura.num_pulsos;
+		liberar_indice(&indice);
+	}
+	else if(lectura->indice_flag){
+		struct IndicePulsos indice = {0};
+		lectura->error = obtener_indice(lectura->ruta, &indice) != 0
+			|| leer_archivo_indice(lectura->ruta, &lectura->almacen, &indice) != 0;
+		lectura->num_pulsos = indice.num_pulsos;
+		liberar_indice(&indice);
+	}
+	else{
+		uint64_t bytes;
+		lectura->error = leer_numero_pulsos_archivo(lectura->ruta, &lectura->num_pulsos, &bytes) != 0
+			|| leer_archivo(lectura->ruta, &lectura->almacen, lectura->num_pulsos, bytes) != 0;
+	}
+	return NULL;
+}
+
+/**
+* @brief Comienza a leer una captura del lote en segundo plano.
+*
+* Si no puede crearse el hilo, la captura se lee en el momento.
+*
+* @param lectura Lectura a iniciar.
+* @param ruta Ruta de la captura.
+* @param indice_flag Si se usa el indice de pulsos de la captura.
+*/
+static void
+iniciar_lectura_lote(struct LecturaLote *lectura, char ruta[], int indice_flag){
+	lectura->ruta = ruta;
+	lectura->indice_flag = indice_flag;
+	lectura->error = 0;
+	lectura->en_curso = pthread_create(&lectura->hilo, NULL, leer_captura_lote, lectura) == 0;
+	if(!lectura->en_curso){
+		leer_captura_lote(lectura);
+	}
+}
+
+/**
+* @brief Procesa todas las capturas de un lote.
+*
+* Mientras el equipo de hilos calcula una captura, un hilo aparte lee la
+* siguiente en un segundo almacen, de modo que la lectura del disco se
+* superpone con el calculo. La matriz de gates se reserva una sola vez, para
+* la captura con mas pulsos vista hasta el momento, y se reutiliza: como el
+* lote viene ordenado de mayor a menor, en general se reserva solo para la
+* primera. El resultado de cada captura se guarda con ruta_salida().
+*
+* Si una captura no puede leerse o guardarse se informa el error y se
+* continua con las demas.
+*
+* @param lote Lote creado con crear_lote().
+* @param gates[] Arreglo de estructuras de tipo gate, sin inicializar.
+* @param opciones Opciones de ejecucion: motor, -l, -i, -o y -e.
+* @param sufijo[] Nombre del archivo de resultados del modo normal.
+* @return Numero de capturas que no pudieron procesarse.
+*/
+int
+procesar_lote(const struct Lote *lote, struct Gate gates[], const struct Opciones *opciones, char sufijo[]){
+	struct LecturaLote lecturas[2];
+	int capacidad = 0, errores = 0;
+
+	if(lote->num_capturas == 0){
+		return 0;
+	}
+	iniciar_lectura_lote(&lecturas[0], lote->rutas[0], opciones->indice_flag);
+
+	for (int k = 0; k < lote->num_capturas; ++k)
+	{
+		struct LecturaLote *actual = &lecturas[k % 2];
+		if(actual->en_curso){
+			pthread_join(actual->hilo, NULL);
+		}
+		if(k+1 < lote->num_capturas){
+			iniciar_lectura_lote(&lecturas[(k+1) % 2], lote->rutas[k+1], opciones->indice_flag);
+		}
+
+		printf("Captura "BOLDGREEN"%d/%d '%s'"RESET"\n", k+1, lote->num_capturas, actual->ruta);
+		if(actual->error){
+			printf(BOLDRED"Error leyendo captura\n"RESET);
+			errores++;
+			continue;
+		}
+		if(actual->num_pulsos == 0){
+			printf(BOLDYELLOW"Captura sin pulsos\n"RESET);
+			liberar_almacen(&actual->almacen);
+			continue;
+		}
+
+		if(actual->num_pulsos > capacidad){
+			if(capacidad > 0){
+				free_gates(gates, capacidad);
+			}
+			initialize_gates(gates, actual->num_pulsos);
+			capacidad = actual->num_pulsos;
+		}
+		if(actual->mapeada){
+			promedio_y_valor_absoluto_captura(&actual->captura, gates);
+			cerrar_captura(&actual->captura);
+		}
+		else{
+			promedio_y_valor_absoluto(&actual->almacen, gates);
+			liberar_almacen(&actual->almacen);
+		}
+
+		int num_lags = lags_calculados(actual->num_pulsos, opciones->num_lags);
+		char *ruta = ruta_salida(actual->ruta, sufijo);
+		struct Formato formato;
+		struct Salida salida;
+		struct Salida *posicional = NULL;
+		preparar_formato(&formato, opciones->formato, actual->num_pulsos, num_lags);
+		if(opciones->posicional_flag){
+			if(abrir_salida(&salida, ruta, &formato) != 0){
+				errores++;
+				free(ruta);
+				continue;
+			}
+			posicional = &salida;
+		}
+		calcular_autocorrelacion_motor(gates, opciones->motor, actual->num_pulsos, num_lags, posicional);
+
+		int error_guardado = posicional != NULL ?
+			cerrar_salida(posicional) :
+			guardar_archivo(gates, ruta, &formato);
+		if(error_guardado != 0){
+			printf(BOLDRED"Error guardando archivo\n"RESET);
+			errores++;
+		}
+		else{
+			printf("Datos guardados en "BOLDGREEN"'%s'\n"RESET, ruta);
+		}
+		free(ruta);
+	}
+
+	if(capacidad > 0){
+		free_gates(gates, capacidad);
+	}
+	return errores;
+}
+
+/**
+* @brief Wrapper de la syscall malloc con control del valor de retorno.
+*
+* Funcion wrapper que verifica el return value de malloc, y si es NULL, 
+* avisa al usuario y finaliza la ejecucion del programa.
+*
+* @param n Cantidad de memoria a reservar.
+* @return p Puntero a la direccion de memoria reservada.
+*/
+void *safe_malloc(size_t n)
+{
+    void *p = malloc(n);
+    if (p == NULL) {
+        fprintf(stderr, "Fatal: failed to allocate %zu bytes.\n", n);
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+
+/**
+* @brief Inicializa los campos de la estructura de tipo Gate para alojar los pulsos leidos.
+*
+* Reserva de una vez la matriz de gates completa, con reservar_matriz(), y apunta
+* las cuatro columnas de cada gate a su lugar en la arena. La reserva depende de
+* la cantidad de pulsos, por lo que se hace en tiempo de ejecucion.
+*
+* Cada gate se escribe por primera vez aqui, con el mismo reparto estatico de
+* gates entre hilos que usa el calculo de la autocorrelacion. Asi sus paginas
+* quedan en el nodo NUMA del hilo que luego las recorre (salvo en los limites
+* entre los rangos de dos hilos, que comparten una pagina).
+*
+* @param gates[] Arreglo de estructuras de tipo gate, con punteros sin inicializar.
+* @param cant_pulsos_archivo Cantidad de pulsos leida en el archivo, para reservar memoria.
+*/
+void
+initialize_gates(struct Gate gates[], int cant_pulsos_archivo){
+	float *matriz = reservar_matriz(cant_pulsos_archivo, omp_get_max_threads());
+	size_t bytes_columna = largo_columna(cant_pulsos_archivo) * sizeof(float);
+
+	#pragma omp parallel for schedule(static) default(none) shared(matriz, bytes_columna, cant_pulsos_archivo, gates, radar)
+	for (int i = 0; i < radar.num_gates; ++i)
+	{
+		gates[i].absol_v = columna_gate(matriz, cant_pulsos_archivo, REGION_ABSOL_V, i);
+		gates[i].absol_h = columna_gate(matriz, cant_pulsos_archivo, REGION_ABSOL_H, i);
+		gates[i].vector_autocorr_v = columna_gate(matriz, cant_pulsos_archivo, REGION_AUTOCORR_V, i);
+		gates[i].vector_autocorr_h = columna_gate(matriz, cant_pulsos_archivo, REGION_AUTOCORR_H, i);
+		memset(gates[i].absol_v, 0, bytes_columna);
+		memset(gates[i].absol_h, 0, bytes_columna);
+		memset(gates[i].vector_autocorr_v, 0, bytes_columna);
+		memset(gates[i].vector_autocorr_h, 0, bytes_columna);
+		//primer acceso a las paginas del gate
+	}
+}
+
+/**
+* @brief Libera la memoria reservada previamente para los valores absolutos de las mediciones.
+*
+* Devuelve al sistema la porcion de la matriz de gates que guarda los valores
+* absolutos de las mediciones, ya que no se necesitan mas. Las columnas de
+* autocorrelacion siguen disponibles hasta free_gates().
+*
+* @param gates[] Arreglo de estructuras de tipo gate, inicializado con initialize_gates().
+* @param cant_pulsos_archivo Cantidad de pulsos con que se inicializo el arreglo.
+*/
+void
+free_absolute_values_gates(struct Gate gates[], int cant_pulsos_archivo){
+	descartar_modulos(gates[0].absol_v, cant_pulsos_archivo);
+}
+
+/**
+* @brief Libera la matriz de gates completa.
+*
+* @param gates[] Arreglo de estructuras de tipo gate, inicializado con initialize_gates().
+* @param cant_pulsos_archivo Cantidad de pulsos con que se inicializo el arreglo.
+*/
+void
+free_gates(struct Gate gates[], int cant_pulsos_archivo){
+	liberar_matriz(gates[0].absol_v, cant_pulsos_archivo);
+	//absol_v del primer gate es el comienzo de la arena
+}
+
+/**
+* @brief Redirige la salida estandar a /dev/null, o la restaura.
+*
+* Las funciones del motor informan cada etapa por la salida estandar; los
+* programas de medicion la silencian mientras miden, para no medir la terminal
+* ni mezclar esa salida con su resumen.
+*
+* @param silenciar 1 para silenciar, 0 para restaurar.
+*/
+void
+silenciar_salida(int silenciar){
+	static int original = -1;
+	fflush(stdout);
+	if(silenciar && original < 0){
+		int nulo = open("/dev/null", O_WRONLY);
+		if(nulo >= 0){
+			original = dup(STDOUT_FILENO);
+			dup2(nulo, STDOUT_FILENO);
+			close(nulo);
+		}
+	}
+	else if(!silenciar && original >= 0){
+		dup2(original, STDOUT_FILENO);
+		close(original);
+		original = -1;
+	}
+}
+
+/**
+* @brief Guarda en un archivo de texto el numero de hilos y el tiempo de ejecucion.
+*
+* @param execution_time Tiempo de ejecucion [s]
+* @param hilos Numero de hilos que ejecutaron el programa.
+* @param filename[] Nombre del archivo a guardar los datos.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+save_time_to_file(double execution_time, int hilos, char filename[]){
+	FILE* f = fopen(filename,"a");
+	if(!f){
+		printf(BOLDRED"Error abriendo archivo para escritura\n"RESET);
+		return 1;
+	}
+	if(fprintf(f, "%d %f\n",hilos, execution_time) < 0){
+		printf(BOLDRED"Error fwrite\n"RESET);
+		fclose(f);
+		return 1;
+	}
+	fclose(f);
+	return 0;
+}
+
+/**
+* @brief Procesa los argumentos con los que se llamó el programa y setea los flags acorde a ello.
+*
+* Evalúa en un bucle los argumentos.
+* Los valores aceptados son:
+* * -t Muestra por salida standard el tiempo de ejecución.
+* * -s Guarda en un archivo de texto el número de hilos utilizado y el tiempo.
+* * -m Lee el archivo de pulsos mapeandolo en memoria (igual que -r mmap).
+* * -u Lee el archivo de pulsos completo con lecturas asincronas, io_uring u O_DIRECT (igual que -r asincrona).
+* * -r <lectura> Metodo de lectura: "auto" (por defecto), "fread", "mmap" o "asincrona".
+* * -i Usa (y si hace falta construye) el indice de pulsos de la captura.
+* * -f Procesa los pulsos en flujo, sin guardarlos todos en memoria.
+* * -p Procesa los pulsos mientras un hilo lector los lee del archivo.
+* * -c Modo incremental: procesa solo los pulsos agregados desde la ultima ejecucion.
+* * -w <M> <K> Lee los pulsos de la entrada estandar, con una ventana de M pulsos, y emite resultados cada K.
+* * -d <ms> Con -w, latencia maxima admitida por bloque, en milisegundos.
+* * -a <motor> Motor de autocorrelacion: "auto" (por defecto), "directo", "fft" o "simd".
+* * -k <kernels> Kernels vectoriales: "auto" (por defecto), "avx512", "avx2", "sse" o "escalar".
+* * -o Escribe cada gate en su lugar del archivo de resultados apenas se calcula.
+* * -e <formato> Formato del archivo de resultados: "v1" (por defecto), "f32", "f16" o "xor".
+* * -g <gates> Numero de gates del radar (por defecto NUM_GATES_DEFECTO).
+* * -x <muestras> Numero maximo de muestras por pulso (por defecto MAX_DATOS_LECTURA_DEFECTO).
+* * -l <L> Calcula y guarda solo los desplazamientos 0 a L de la autocorrelacion.
+* * -b <lote> Procesa todas las capturas de un directorio o de una lista.
+* * <nro_hilos> Número de hilos a utilizar. Si es un valor incorrecto avisa error.
+* Si el argumento no existe, se informa del error.
+*
+* @param argc Numero de argumentos con que se llamó el programa.
+* @param argv Argumentos con los que se llamó el programa.
+* @param opciones Puntero a las opciones de ejecucion, para modificarlas si es necesario.
+*/
+void
+process_arguments(int argc, char *argv[], struct Opciones* opciones){
+	if(argc > 1){
+		for (int i = 1; i < argc; ++i)
+		{
+			if(strcmp(argv[i],"-t") == 0){
+				opciones->time_flag = 1;
+			}
+			else if(strcmp(argv[i],"-s") == 0){
+				opciones->save_flag = 1;
+			}
+			else if(strcmp(argv[i],"-m") == 0){
+				opciones->lectura = LECTURA_MMAP;
+			}
+			else if(strcmp(argv[i],"-u") == 0){
+				opciones->lectura = LECTURA_ASINCRONA;
+			}
+			else if(strcmp(argv[i],"-i") == 0){
+				opciones->indice_flag = 1;
+			}
+			else if(strcmp(argv[i],"-f") == 0){
+				opciones->flujo_flag = 1;
+			}
+			else if(strcmp(argv[i],"-p") == 0){
+				opciones->pipeline_flag = 1;
+			}
+			else if(strcmp(argv[i],"-o") == 0){
+				opciones->posicional_flag = 1;
+			}
+			else if(strcmp(argv[i],"-c") == 0){
+				opciones->incremental_flag = 1;
+			}
+			else if(strcmp(argv[i],"-w") == 0 && i+2 < argc){
+				opciones->ventana = atoi(argv[i+1]);
+				opciones->paso = atoi(argv[i+2]);
+				i += 2;
+				if(opciones->ventana <= 0 || opciones->ventana > UINT16_MAX || opciones->paso <= 0){
+					printf("Ventana invalida "BOLDRED"%s %s\n"RESET, argv[i-1], argv[i]);
+					opciones->ventana = 0;
+				}
+			}
+			else if(strcmp(argv[i],"-d") == 0 && i+1 < argc){
+				i++;
+				if(atof(argv[i]) > 0){
+					opciones->plazo = atof(argv[i]) / 1000;
+				}
+				else{
+					printf("Plazo invalido "BOLDRED"%s\n"RESET, argv[i]);
+				}
+			}
+			else if(strcmp(argv[i],"-g") == 0 && i+1 < argc){
+				i++;
+				if(atoi(argv[i]) > 0 && atoi(argv[i]) <= MAX_GATES){
+					radar.num_gates = atoi(argv[i]);
+				}
+				else{
+					printf("Numero de gates invalido "BOLDRED"%s\n"RESET, argv[i]);
+				}
+			}
+			else if(strcmp(argv[i],"-x") == 0 && i+1 < argc){
+				i++;
+				if(atoi(argv[i]) > 0 && atoi(argv[i]) <= UINT16_MAX){
+					radar.max_muestras = atoi(argv[i]);
+				}
+				else{
+					printf("Numero maximo de muestras invalido "BOLDRED"%s\n"RESET, argv[i]);
+				}
+			}
+			else if(strcmp(argv[i],"-l") == 0 && i+1 < argc){
+				i++;
+				if(atoi(argv[i]) >= 0 && isdigit((unsigned char)argv[i][0])){
+					opciones->num_lags = atoi(argv[i]) + 1;
+				}
+				else{
+					printf("Desplazamiento maximo invalido "BOLDRED"%s\n"RESET, argv[i]);
+				}
+			}
+			else if(strcmp(argv[i],"-b") == 0 && i+1 < argc){
+				opciones->lote = argv[++i];
+			}
+			else if(strcmp(argv[i],"-a") == 0 && i+1 < argc){
+				i++;
+				if(motor_por_nombre(argv[i]) >= 0){
+					opciones->motor = motor_por_nombre(argv[i]);
+				}
+				else{
+					printf("No se reconoce el motor de autocorrelacion "BOLDRED"%s\n"RESET, argv[i]);
+				}
+			}
+			else if(strcmp(argv[i],"-r") == 0 && i+1 < argc){
+				i++;
+				if(lectura_por_nombre(argv[i]) >= 0){
+					opciones->lectura = lectura_por_nombre(argv[i]);
+				}
+				else{
+					printf("No se reconoce el metodo de lectura "BOLDRED"%s\n"RESET, argv[i]);
+				}
+			}
+			else if(strcmp(argv[i],"-k") == 0 && i+1 < argc){
+				opciones->kernels = argv[++i];
+			}
+			else if(atoi(argv[i]) != 0){
+				int aux = atoi(argv[i]);
+				if((aux > 0) && (aux < MAX_NUM_THREADS)){
+					opciones->num_threads = aux;
+				}
+				else{
+					opciones->num_threads = omp_get_max_threads();
+					printf(BOLDRED"Error"RESET", no puede ejecutarse el programa con "BOLDRED"%s"RESET" hilos.\n", argv[i]);
+				}
+			}
+			else if(strcmp(argv[i],"-e") == 0 && i+1 < argc){
+				i++;
+				if(codificacion_formato(argv[i]) >= 0){
+					opciones->formato = codificacion_formato(argv[i]);
+				}
+				else{
+					printf("No se reconoce el formato de resultados "BOLDRED"%s\n"RESET, argv[i]);
+				}
+			}
+			else{
+				printf("No se reconoce el comando "BOLDRED"%s\n"RESET, argv[i]);
+			}
+		}
+	}
+	if(opciones->posicional_flag && opciones->formato == FORMATO_XOR){
+		printf(BOLDYELLOW"El formato xor no tiene gates de tamaño fijo, se ignora -o\n"RESET);
+		opciones->posicional_flag = 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,399 @@
+/** @file generador.c
+ *  @brief Generador de capturas sinteticas.
+ *
+ *  Escribe archivos de pulsos con el mismo formato que lee leer_archivo():
+ *  por cada pulso, el numero de muestras (uint16_t), los pares I/Q de la
+ *  componente vertical y luego los de la horizontal, en float. El numero de
+ *  pulsos, la distribucion del numero de muestras, el modelo de señal y la
+ *  semilla se eligen por linea de comandos, para producir capturas grandes o
+ *  patologicas y reproducibles.
+ *
+ *  Cada pulso tiene su propio generador de numeros aleatorios, derivado de la
+ *  semilla y del numero de pulso, por lo que el archivo es el mismo con
+ *  cualquier numero de hilos.
+ *
+ *  @author Facundo Maero
+ */
+
+#include "../include/func_radar.h"
+#include <inttypes.h>
+
+#define PULSOS_GENERADOR 200
+/*!< Pulsos de la captura, salvo que se indique otro numero con -p. */
+#define BLOQUE_GENERADOR 64
+/*!< Pulsos que se generan en paralelo antes de escribirlos en orden. */
+#define BLANCOS_ECO 4
+/*!< Blancos del modelo de eco: zonas de distancia con mayor reflectividad. */
+
+#define DISTRIBUCION_FIJA 0
+/*!< Todos los pulsos con a muestras. */
+#define DISTRIBUCION_UNIFORME 1
+/*!< Muestras uniformes entre a y b. */
+#define DISTRIBUCION_NORMAL 2
+/*!< Muestras normales con media a y desvio b. */
+#define DISTRIBUCION_EXTREMOS 3
+/*!< Cada pulso con a o con b muestras, al azar: carga muy desigual entre pulsos vecinos. */
+#define DISTRIBUCION_RAMPA 4
+/*!< Muestras crecientes de a (primer pulso) a b (ultimo): la carga se concentra al final de la captura. */
+
+#define SENAL_RUIDO 0
+/*!< Ruido gaussiano complejo en cada muestra. */
+#define SENAL_ECO 1
+/*!< Ecos de blancos en distancia, con amplitud que fluctua de pulso a pulso, mas ruido. */
+
+static const struct EntradaBackend distribuciones[] = {
+	{"fija", DISTRIBUCION_FIJA},
+	{"uniforme", DISTRIBUCION_UNIFORME},
+	{"normal", DISTRIBUCION_NORMAL},
+	{"extremos", DISTRIBUCION_EXTREMOS},
+	{"rampa", DISTRIBUCION_RAMPA},
+	{NULL, 0}
+};
+/*!< Distribuciones del numero de muestras por pulso, para la opcion -d. */
+
+static const struct EntradaBackend senales[] = {
+	{"ruido", SENAL_RUIDO},
+	{"eco", SENAL_ECO},
+	{NULL, 0}
+};
+/*!< Modelos de señal, para la opcion -s. */
+
+struct OpcionesGenerador{
+	char *archivo;
+	int num_pulsos;
+	int distribucion;
+	double a;
+	double b;
+	int senal;
+	uint64_t semilla;
+};
+/*!< Opciones del generador recibidas por linea de comandos. */
+
+struct Aleatorio{
+	uint64_t estado;
+	int hay_normal;
+	double normal;
+};
+/*!< Generador de numeros aleatorios (splitmix64), con la segunda normal de Box-Muller guardada. */
+
+/**
+* @brief Siguiente numero del generador splitmix64.
+*
+* @param aleatorio Generador.
+* @return 64 bits aleatorios.
+*/
+static uint64_t
+siguiente(struct Aleatorio *aleatorio){
+	uint64_t z = (aleatorio->estado += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/**
+* @brief Inicializa un generador para un flujo de la semilla (por ejemplo, un pulso).
+*
+* @param aleatorio Generador a inicializar.
+* @param semilla Semilla de la captura.
+* @param flujo Numero de flujo.
+*/
+static void
+sembrar(struct Aleatorio *aleatorio, uint64_t semilla, uint64_t flujo){
+	aleatorio->estado = semilla;
+	aleatorio->estado = siguiente(aleatorio) ^ (flujo * 0xd1b54a32d192ed03ULL);
+	aleatorio->hay_normal = 0;
+}
+
+/**
+* @brief Numero uniforme en [0, 1).
+*/
+static double
+uniforme(struct Aleatorio *aleatorio){
+	return (siguiente(aleatorio) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+* @brief Numero normal estandar, por el metodo de Box-Muller.
+*/
+static double
+normal(struct Aleatorio *aleatorio){
+	if(aleatorio->hay_normal){
+		aleatorio->hay_normal = 0;
+		return aleatorio->normal;
+	}
+	double u = 1.0 - uniforme(aleatorio);
+	double v = uniforme(aleatorio);
+	double r = sqrt(-2.0 * log(u));
+	aleatorio->normal = r * sin(2 * M_PI * v);
+	aleatorio->hay_normal = 1;
+	return r * cos(2 * M_PI * v);
+}
+
+/**
+* @brief Numero de muestras de un pulso segun la distribucion elegida.
+*
+* El resultado se recorta a [0, radar.max_muestras]: un pulso puede no tener
+* muestras (valid_samples == 0), el caso mas patologico para el lector.
+*
+* @param opciones Opciones del generador.
+* @param pulso Numero de pulso.
+* @param aleatorio Generador de la distribucion.
+* @return Numero de muestras del pulso.
+*/
+static int
+muestras_pulso(const struct OpcionesGenerador *opciones, int pulso, struct Aleatorio *aleatorio){
+	double muestras;
+	switch(opciones->distribucion){
+		case DISTRIBUCION_UNIFORME:
+			muestras = opciones->a + floor(uniforme(aleatorio) * (opciones->b - opciones->a + 1));
+			break;
+		case DISTRIBUCION_NORMAL:
+			muestras = round(opciones->a + opciones->b * normal(aleatorio));
+			break;
+		case DISTRIBUCION_EXTREMOS:
+			muestras = uniforme(aleatorio) < 0.5 ? opciones->a : opciones->b;
+			break;
+		case DISTRIBUCION_RAMPA:
+			muestras = round(opciones->a + (opciones->b - opciones->a) * pulso / (opciones->num_pulsos > 1 ? opciones->num_pulsos - 1 : 1));
+			break;
+		default:
+			muestras = opciones->a;
+	}
+	if(muestras < 0){
+		return 0;
+	}
+	return muestras > radar.max_muestras ? radar.max_muestras : (int)muestras;
+}
+
+/**
+* @brief Genera la tabla de un pulso: pares I/Q verticales y luego horizontales.
+*
+* En el modelo de eco, la reflectividad de cada muestra (distancia) es la suma
+* de BLANCOS_ECO campanas, con posiciones y anchos fijos para toda la captura.
+* Su amplitud fluctua de pulso a pulso con una frecuencia propia de cada
+* blanco, y la fase avanza con su velocidad Doppler. La componente horizontal
+* es la vertical atenuada, mas ruido independiente.
+*
+* @param opciones Opciones del generador.
+* @param pulso Numero de pulso.
+* @param valid_samples Numero de muestras del pulso.
+* @param tabla[] Tabla a completar, de 4*valid_samples floats.
+*/
+static void
+generar_tabla(const struct OpcionesGenerador *opciones, int pulso, int valid_samples, float tabla[]){
+	struct Aleatorio aleatorio, blancos;
+	float *horizontal = tabla + 2*valid_samples;
+	sembrar(&aleatorio, opciones->semilla, (uint64_t)pulso + 1);
+
+	if(opciones->senal == SENAL_RUIDO){
+		for (int i = 0; i < 4*valid_samples; ++i)
+		{
+			tabla[i] = normal(&aleatorio);
+		}
+		return;
+	}
+
+	double centro[BLANCOS_ECO], ancho[BLANCOS_ECO], eco_re[BLANCOS_ECO], eco_im[BLANCOS_ECO];
+	sembrar(&blancos, opciones->semilla, 0);
+	for (int k = 0; k < BLANCOS_ECO; ++k)
+	{
+		double frecuencia = 0.005 + 0.05 * uniforme(&blancos);
+		double doppler = 0.5 * uniforme(&blancos) - 0.25;
+		centro[k] = uniforme(&blancos);
+		ancho[k] = 0.01 + 0.05 * uniforme(&blancos);
+		double amplitud = (5 + 20 * uniforme(&blancos)) * (1 + 0.5 * cos(2 * M_PI * frecuencia * pulso));
+		double fase = 2 * M_PI * (doppler * pulso + uniforme(&blancos));
+		eco_re[k] = amplitud * cos(fase);
+		eco_im[k] = amplitud * sin(fase);
+	}
+	for (int i = 0; i < valid_samples; ++i)
+	{
+		double distancia = (double)i / valid_samples, re = 0, im = 0;
+		for (int k = 0; k < BLANCOS_ECO; ++k)
+		{
+			double d = (distancia - centro[k]) / ancho[k];
+			double perfil = exp(-0.5 * d * d);
+			re += eco_re[k] * perfil;
+			im += eco_im[k] * perfil;
+		}
+		tabla[2*i] = re + normal(&aleatorio);
+		tabla[2*i+1] = im + normal(&aleatorio);
+		horizontal[2*i] = 0.7 * re + normal(&aleatorio);
+		horizontal[2*i+1] = 0.7 * im + normal(&aleatorio);
+	}
+}
+
+/**
+* @brief Genera la captura y la escribe en el archivo elegido.
+*
+* El numero de muestras de todos los pulsos se sortea primero, con un flujo
+* propio. Luego los pulsos se generan de a BLOQUE_GENERADOR en paralelo, en un
+* buffer, y se escriben en orden.
+*
+* @param opciones Opciones del generador.
+* @param bytes Bytes escritos.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+static int
+generar_captura(const struct OpcionesGenerador *opciones, uint64_t *bytes){
+	struct Aleatorio aleatorio;
+	uint16_t *muestras = safe_malloc(sizeof(uint16_t) * opciones->num_pulsos);
+	size_t offsets[BLOQUE_GENERADOR + 1];
+	unsigned char *buffer = safe_malloc(BLOQUE_GENERADOR * (sizeof(uint16_t) + 4*sizeof(float)*(size_t)radar.max_muestras));
+	FILE *f = fopen(opciones->archivo, "wb");
+	int error = f == NULL;
+
+	sembrar(&aleatorio, opciones->semilla, 0xd15);
+	for (int p = 0; p < opciones->num_pulsos; ++p)
+	{
+		muestras[p] = muestras_pulso(opciones, p, &aleatorio);
+	}
+
+	*bytes = 0;
+	for (int inicio = 0; inicio < opciones->num_pulsos && !error; inicio += BLOQUE_GENERADOR)
+	{
+		int cantidad = opciones->num_pulsos - inicio < BLOQUE_GENERADOR ? opciones->num_pulsos - inicio : BLOQUE_GENERADOR;
+		offsets[0] = 0;
+		for (int p = 0; p < cantidad; ++p)
+		{
+			offsets[p+1] = offsets[p] + sizeof(uint16_t) + 4*sizeof(float)*muestras[inicio+p];
+		}
+
+		#pragma omp parallel default(none) shared(opciones, muestras, offsets, buffer, inicio, cantidad, radar)
+		{
+			float *tabla = safe_malloc(4*sizeof(float)*radar.max_muestras);
+			#pragma omp for schedule(dynamic)
+			for (int p = 0; p < cantidad; ++p)
+			{
+				generar_tabla(opciones, inicio+p, muestras[inicio+p], tabla);
+				memcpy(buffer + offsets[p], &muestras[inicio+p], sizeof(uint16_t));
+				memcpy(buffer + offsets[p] + sizeof(uint16_t), tabla, 4*sizeof(float)*muestras[inicio+p]);
+			}
+			free(tabla);
+		}
+
+		error = fwrite(buffer, 1, offsets[cantidad], f) != offsets[cantidad];
+		*bytes += offsets[cantidad];
+	}
+
+	if(f != NULL && fclose(f) != 0){
+		error = 1;
+	}
+	free(buffer);
+	free(muestras);
+	return error;
+}
+
+/**
+* @brief Lee los parametros de una distribucion, "nombre:a[:b]".
+*
+* @param texto[] Distribucion, por ejemplo "uniforme:100:5900".
+* @param opciones Opciones donde guardarla.
+* @return 1 si no es valida, 0 caso contrario.
+*/
+static int
+leer_distribucion(const char texto[], struct OpcionesGenerador *opciones){
+	char nombre[16] = "";
+	double a, b = 0;
+	int leidos = sscanf(texto, "%15[^:]:%lf:%lf", nombre, &a, &b);
+	const struct EntradaBackend *entrada = distribuciones;
+	while(entrada->nombre != NULL && strcmp(entrada->nombre, nombre) != 0){
+		entrada++;
+	}
+	if(entrada->nombre == NULL || leidos < 2 || (entrada->valor != DISTRIBUCION_FIJA && leidos < 3)){
+		return 1;
+	}
+	opciones->distribucion = entrada->valor;
+	opciones->a = a;
+	opciones->b = b;
+	return 0;
+}
+
+/**
+* @brief Procesa los argumentos del generador.
+*
+* Los valores aceptados son:
+* * -p <pulsos> Numero de pulsos (200 por defecto).
+* * -d <distribucion> Numero de muestras por pulso: "fija:N" (por defecto
+* 	fija:4400), "uniforme:A:B", "normal:MEDIA:DESVIO", "extremos:A:B" o "rampa:A:B".
+* * -s <señal> Modelo de señal: "eco" (por defecto) o "ruido".
+* * -r <semilla> Semilla (1 por defecto).
+* * -x <muestras> Numero maximo de muestras por pulso, como en build/radar.
+* * <archivo> Archivo a generar ("sintetico.iq" por defecto).
+*
+* @param argc Cantidad de argumentos.
+* @param argv[] Argumentos.
+* @param opciones Opciones a completar.
+*/
+static void
+procesar_argumentos_generador(int argc, char *argv[], struct OpcionesGenerador *opciones){
+	for (int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i],"-p") == 0 && i+1 < argc){
+			i++;
+			if(atoi(argv[i]) > 0){
+				opciones->num_pulsos = atoi(argv[i]);
+			}
+			else{
+				printf("Numero de pulsos invalido "BOLDRED"%s\n"RESET, argv[i]);
+			}
+		}
+		else if(strcmp(argv[i],"-d") == 0 && i+1 < argc){
+			i++;
+			if(leer_distribucion(argv[i], opciones) != 0){
+				printf("Distribucion de muestras invalida "BOLDRED"%s\n"RESET, argv[i]);
+			}
+		}
+		else if(strcmp(argv[i],"-s") == 0 && i+1 < argc){
+			const struct EntradaBackend *entrada = senales;
+			i++;
+			while(entrada->nombre != NULL && strcmp(entrada->nombre, argv[i]) != 0){
+				entrada++;
+			}
+			if(entrada->nombre != NULL){
+				opciones->senal = entrada->valor;
+			}
+			else{
+				printf("No se reconoce el modelo de señal "BOLDRED"%s\n"RESET, argv[i]);
+			}
+		}
+		else if(strcmp(argv[i],"-r") == 0 && i+1 < argc){
+			opciones->semilla = strtoull(argv[++i], NULL, 10);
+		}
+		else if(strcmp(argv[i],"-x") == 0 && i+1 < argc){
+			i++;
+			if(atoi(argv[i]) > 0 && atoi(argv[i]) <= UINT16_MAX){
+				radar.max_muestras = atoi(argv[i]);
+			}
+			else{
+				printf("Numero maximo de muestras invalido "BOLDRED"%s\n"RESET, argv[i]);
+			}
+		}
+		else if(argv[i][0] != '-'){
+			opciones->archivo = argv[i];
+		}
+		else{
+			printf("No se reconoce el comando "BOLDRED"%s\n"RESET, argv[i]);
+		}
+	}
+}
+
+ /**
+* @brief Función main del generador de capturas.
+*/
+int
+main(int argc, char *argv[])
+{
+	struct OpcionesGenerador opciones = {"sintetico.iq", PULSOS_GENERADOR, DISTRIBUCION_FIJA, 4400, 0, SENAL_ECO, 1};
+	uint64_t bytes;
+
+	procesar_argumentos_generador(argc, argv, &opciones);
+	double inicio = omp_get_wtime();
+	if(generar_captura(&opciones, &bytes) != 0){
+		printf(BOLDRED"Error escribiendo '%s'\n"RESET, opciones.archivo);
+		exit(EXIT_FAILURE);
+	}
+	printf("Captura "BOLDGREEN"'%s'"RESET": "BOLDGREEN"%d"RESET" pulsos, "BOLDGREEN"%" PRIu64 RESET" bytes, en %.2f segundos\n",
+		opciones.archivo, opciones.num_pulsos, bytes, omp_get_wtime() - inicio);
+	return 0;
+}
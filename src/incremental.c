@@ -0,0 +1,385 @@
+/** @file incremental.c
+ *  @brief Autocorrelacion incremental de una captura que crece.
+ *
+ *  El estado se guarda junto a la captura (pulsos.iq.acf). Se asume que la
+ *  captura solo crece agregando pulsos al final: si es mas corta que la parte
+ *  ya procesada, o esa parte cambio, el estado se descarta y se procesa la
+ *  captura completa. Para detectar una captura reemplazada sin recorrerla, el
+ *  estado guarda una suma de control del comienzo y del final de la parte
+ *  procesada (que incluye el ultimo pulso), y su fecha de modificacion, que
+ *  debe coincidir si la captura no crecio.
+ *
+ *  Las sumas se acumulan en doble precision, por lo que el resultado puede
+ *  diferir en el ultimo bit del calculo directo, que acumula en float.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/radar.h"
+#include "../include/incremental.h"
+#include <string.h>
+#include <sys/stat.h>
+
+struct EncabezadoEstado{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t num_gates;
+	uint32_t num_pulsos;
+	uint64_t offset;
+	uint32_t max_lags;
+	uint32_t reservado;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	uint64_t suma_control;
+};
+/*!< Encabezado del archivo de estado. Le siguen las colas de las columnas
+absol_v y absol_h de cada gate, en float, y luego las sumas de cada gate, en
+double. La fecha de modificacion es la de la captura al guardar el estado. */
+
+/**
+* @brief Arma el nombre del archivo de estado de una captura.
+*
+* @param file_name[] Nombre de la captura.
+* @param extension Sufijo adicional, o "" para el nombre definitivo.
+* @return Nombre del archivo de estado, reservado con safe_malloc.
+*/
+static char *
+nombre_estado(char file_name[], const char *extension){
+	char *nombre = safe_malloc(strlen(file_name) + strlen(ESTADO_EXTENSION) + strlen(extension) + 1);
+	strcpy(nombre, file_name);
+	strcat(nombre, ESTADO_EXTENSION);
+	strcat(nombre, extension);
+	return nombre;
+}
+
+/**
+* @brief Suma de control (FNV-1a de 64 bits) de la parte procesada de una captura.
+*
+* Cubre los primeros y los ultimos ESTADO_VENTANA_CONTROL bytes antes de
+* offset (toda la parte procesada, si es mas corta), por lo que su costo no
+* crece con la captura.
+*
+* @param f Captura abierta.
+* @param offset Numero de bytes procesados.
+* @param suma Puntero para retornar la suma de control.
+* @return 1 si no se pudo leer la captura, 0 caso contrario.
+*/
+static int
+suma_control_captura(FILE *f, uint64_t offset, uint64_t *suma){
+	unsigned char buffer[1 << 16];
+	uint64_t tramos[2][2] = {
+		{0, offset < ESTADO_VENTANA_CONTROL ? offset : ESTADO_VENTANA_CONTROL},
+		{offset > 2*ESTADO_VENTANA_CONTROL ? offset - ESTADO_VENTANA_CONTROL : 0, offset}
+	};
+	if(offset <= 2*ESTADO_VENTANA_CONTROL){
+		tramos[0][1] = offset;
+		tramos[1][1] = 0;
+	}
+
+	*suma = 0xcbf29ce484222325ULL;
+	for (int t = 0; t < 2; ++t)
+	{
+		if(tramos[t][1] > tramos[t][0] && fseeko(f, tramos[t][0], SEEK_SET) != 0){
+			return 1;
+		}
+		for (uint64_t pos = tramos[t][0]; pos < tramos[t][1];)
+		{
+			size_t n = tramos[t][1] - pos < sizeof(buffer) ? tramos[t][1] - pos : sizeof(buffer);
+			if(fread(buffer, 1, n, f) != n){
+				return 1;
+			}
+			for (size_t i = 0; i < n; ++i)
+			{
+				*suma = (*suma ^ buffer[i]) * 0x100000001b3ULL;
+			}
+			pos += n;
+		}
+	}
+	return 0;
+}
+
+/**
+* @brief Numero de modulos de cada gate que se guardan en el estado.
+*
+* El pulso m aporta a los desplazamientos i < max_lags el producto con el pulso
+* m-i, por lo que para extender un gate alcanza con sus ultimos max_lags-1
+* modulos. Sin limite de desplazamientos hace falta la columna completa.
+*
+* @param num_pulsos Numero de pulsos procesados.
+* @param max_lags Opcion -l (L+1), o 0 si no se limita.
+* @return Numero de modulos por gate a guardar.
+*/
+int
+cola_estado(int num_pulsos, int max_lags){
+	return (max_lags > 0 && max_lags - 1 < num_pulsos) ? max_lags - 1 : num_pulsos;
+}
+
+/**
+* @brief Lee el contenido de un archivo de estado ya abierto.
+*
+* La parte ya procesada de la captura debe seguir siendo la misma: su suma de
+* control debe coincidir con la guardada, y si la captura no crecio desde que
+* se guardo el estado, tambien su fecha de modificacion.
+*
+* @param f Archivo de estado, posicionado al comienzo.
+* @param captura Captura abierta, para validar el estado.
+* @param st Datos actuales de la captura.
+* @param max_lags Opcion -l de esta ejecucion, que debe coincidir con la del estado.
+* @param estado Estructura donde cargar el estado.
+* @return 1 si el archivo no es valido para la captura, 0 caso contrario.
+*/
+static int
+leer_estado(FILE *f, FILE *captura, const struct stat *st, int max_lags, struct EstadoIncremental *estado){
+	struct EncabezadoEstado encabezado;
+	uint64_t suma;
+	if(fread(&encabezado, sizeof(encabezado), 1, f) != 1
+		|| encabezado.magic != ESTADO_MAGIC
+		|| encabezado.version != ESTADO_VERSION
+		|| encabezado.num_gates != radar.num_gates
+		|| encabezado.offset > (uint64_t)st->st_size
+		|| encabezado.max_lags != (uint32_t)max_lags
+		|| (encabezado.offset == (uint64_t)st->st_size
+			&& (encabezado.mtime_sec != (int64_t)st->st_mtim.tv_sec || encabezado.mtime_nsec != (int64_t)st->st_mtim.tv_nsec))
+		|| suma_control_captura(captura, encabezado.offset, &suma) != 0
+		|| suma != encabezado.suma_control){
+		return 1;
+	}
+
+	size_t columnas = (size_t)radar.num_gates * cola_estado(encabezado.num_pulsos, max_lags);
+	size_t sumas = (size_t)radar.num_gates * lags_calculados(encabezado.num_pulsos, max_lags);
+	estado->num_pulsos = encabezado.num_pulsos;
+	estado->offset = encabezado.offset;
+	estado->columnas_v = safe_malloc(sizeof(float) * (columnas > 0 ? columnas : 1));
+	estado->columnas_h = safe_malloc(sizeof(float) * (columnas > 0 ? columnas : 1));
+	estado->sumas_v = safe_malloc(sizeof(double) * (sumas > 0 ? sumas : 1));
+	estado->sumas_h = safe_malloc(sizeof(double) * (sumas > 0 ? sumas : 1));
+	if(fread(estado->columnas_v, sizeof(float), columnas, f) != columnas
+		|| fread(estado->columnas_h, sizeof(float), columnas, f) != columnas
+		|| fread(estado->sumas_v, sizeof(double), sumas, f) != sumas
+		|| fread(estado->sumas_h, sizeof(double), sumas, f) != sumas){
+		liberar_estado(estado);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+* @brief Carga el estado incremental guardado de una captura.
+*
+* Si no hay estado guardado, o no corresponde a la captura, el estado queda
+* vacio (cero pulsos procesados) y se avisa al usuario; no es un error.
+*
+* Un estado guardado con otra opcion -l tampoco corresponde: sus sumas no
+* cubren los mismos desplazamientos. Ni uno cuya parte procesada de la
+* captura cambio (por ejemplo, si la captura se reemplazo por otra).
+*
+* @param file_name[] El nombre de la captura.
+* @param max_lags Opcion -l (L+1), o 0 si no se limita.
+* @param estado Estructura donde cargar el estado. Debe liberarse con liberar_estado().
+*/
+void
+cargar_estado(char file_name[], int max_lags, struct EstadoIncremental *estado){
+	struct stat st;
+	char *archivo_estado = nombre_estado(file_name, "");
+	FILE *f = fopen(archivo_estado, "rb");
+	FILE *captura = NULL;
+
+	memset(estado, 0, sizeof(*estado));
+	estado->max_lags = max_lags;
+	if(!f){
+		printf("Sin estado previo en "BOLDGREEN"'%s'"RESET", se procesa la captura completa\n", archivo_estado);
+	}
+	else if((captura = fopen(file_name, "rb")) == NULL || fstat(fileno(captura), &st) != 0
+		|| leer_estado(f, captura, &st, max_lags, estado) != 0){
+		printf(BOLDYELLOW"El estado '%s' no corresponde a la captura, se procesa la captura completa\n"RESET, archivo_estado);
+		memset(estado, 0, sizeof(*estado));
+		estado->max_lags = max_lags;
+	}
+	else{
+		printf("Usando estado "BOLDGREEN"'%s'"RESET": "BOLDGREEN"%d"RESET" pulsos ya procesados\n", archivo_estado, estado->num_pulsos);
+	}
+
+	if(f) fclose(f);
+	if(captura) fclose(captura);
+	free(archivo_estado);
+}
+
+/**
+* @brief Guarda el estado incremental de una captura.
+*
+* Se escribe primero en un archivo temporal, que luego reemplaza al anterior,
+* para no dejar un estado a medio escribir si la ejecucion se interrumpe.
+* Guarda ademas la suma de control de los estado->offset bytes procesados y la
+* fecha de modificacion de la captura, para validarla en la proxima ejecucion.
+*
+* @param file_name[] El nombre de la captura.
+* @param estado Estado a guardar, ya actualizado con todos los pulsos procesados.
+* @param gates[] Arreglo de gates, con las columnas absol_v y absol_h de los
+* estado->num_pulsos pulsos. Se guarda solo su cola.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+guardar_estado(char file_name[], const struct EstadoIncremental *estado, const struct Gate gates[]){
+	struct stat st;
+	struct EncabezadoEstado encabezado = {
+		ESTADO_MAGIC, ESTADO_VERSION, radar.num_gates, estado->num_pulsos, estado->offset, estado->max_lags, 0, 0, 0, 0
+	};
+	size_t n = (size_t)radar.num_gates * lags_calculados(estado->num_pulsos, estado->max_lags);
+	size_t por_gate = cola_estado(estado->num_pulsos, estado->max_lags);
+	size_t inicio_cola = estado->num_pulsos - por_gate;
+	int error = 0;
+	char *archivo_estado = nombre_estado(file_name, "");
+	char *temporal = nombre_estado(file_name, ".tmp");
+
+	FILE *captura = fopen(file_name, "rb");
+	if(!captura || fstat(fileno(captura), &st) != 0 || suma_control_captura(captura, estado->offset, &encabezado.suma_control) != 0){
+		if(captura) fclose(captura);
+		free(archivo_estado);
+		free(temporal);
+		return 1;
+	}
+	fclose(captura);
+	encabezado.mtime_sec = st.st_mtim.tv_sec;
+	encabezado.mtime_nsec = st.st_mtim.tv_nsec;
+
+	FILE *f = fopen(temporal, "wb");
+	if(!f){
+		free(archivo_estado);
+		free(temporal);
+		return 1;
+	}
+
+	error |= fwrite(&encabezado, sizeof(encabezado), 1, f) != 1;
+	for (int j = 0; j < radar.num_gates && !error; ++j)
+	{
+		error |= fwrite(gates[j].absol_v + inicio_cola, sizeof(float), por_gate, f) != por_gate;
+	}
+	for (int j = 0; j < radar.num_gates && !error; ++j)
+	{
+		error |= fwrite(gates[j].absol_h + inicio_cola, sizeof(float), por_gate, f) != por_gate;
+	}
+	error |= !error && fwrite(estado->sumas_v, sizeof(double), n, f) != n;
+	error |= !error && fwrite(estado->sumas_h, sizeof(double), n, f) != n;
+	error |= fclose(f) != 0;
+
+	if(error || rename(temporal, archivo_estado) != 0){
+		remove(temporal);
+		error = 1;
+	}
+	free(archivo_estado);
+	free(temporal);
+	return error;
+}
+
+/**
+* @brief Libera la memoria de un estado incremental.
+*
+* @param estado Estado cargado con cargar_estado().
+*/
+void
+liberar_estado(struct EstadoIncremental *estado){
+	free(estado->columnas_v);
+	free(estado->columnas_h);
+	free(estado->sumas_v);
+	free(estado->sumas_h);
+	estado->columnas_v = NULL;
+	estado->columnas_h = NULL;
+	estado->sumas_v = NULL;
+	estado->sumas_h = NULL;
+}
+
+/**
+* @brief Cuenta los pulsos completos agregados a la captura despues de un offset.
+*
+* Recorre los encabezados desde offset, igual que leer_numero_pulsos_archivo().
+* Un pulso que todavia no se termino de escribir al final del archivo no se
+* cuenta: se procesara en la proxima ejecucion.
+*
+* @param file_name[] El nombre de la captura.
+* @param offset Posicion del primer pulso no procesado.
+* @param num_nuevos Puntero para retornar el numero de pulsos nuevos.
+* @param fin Puntero para retornar la posicion siguiente al ultimo pulso nuevo.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+contar_pulsos_nuevos(char file_name[], uint64_t offset, int *num_nuevos, uint64_t *fin){
+	struct stat st;
+	uint16_t valid_samples;
+	FILE *ptr = fopen(file_name, "rb");
+
+	*num_nuevos = 0;
+	*fin = offset;
+	if(!ptr){
+		printf(BOLDRED"Unable to open file!\n"RESET);
+		return 1;
+	}
+	if(fstat(fileno(ptr), &st) != 0 || fseeko(ptr, offset, SEEK_SET) != 0){
+		printf(BOLDRED"Error seeking file\n"RESET);
+		fclose(ptr);
+		return 1;
+	}
+
+	while(*fin + sizeof(uint16_t) <= (uint64_t)st.st_size){
+		if(fread(&valid_samples, sizeof(uint16_t), 1, ptr) != 1){
+			printf(BOLDRED"Error fread\n"RESET);
+			fclose(ptr);
+			return 1;
+		}
+		uint64_t siguiente = *fin + sizeof(uint16_t) + valid_samples*4*sizeof(float);
+		if(siguiente > (uint64_t)st.st_size || fseeko(ptr, siguiente, SEEK_SET) != 0){
+			break;
+			//el ultimo pulso todavia se esta escribiendo
+		}
+		*fin = siguiente;
+		(*num_nuevos)++;
+	}
+
+	fclose(ptr);
+	printf("Se encontró informacion de "BOLDGREEN"%d"RESET" pulsos nuevos.\n", *num_nuevos);
+	return 0;
+}
+
+/**
+* @brief Copia a los gates las colas de las columnas de modulos guardadas en el estado.
+*
+* Cada cola se copia en su posicion original, al final de los
+* estado->num_pulsos pulsos ya procesados.
+*
+* @param estado Estado cargado con cargar_estado().
+* @param gates[] Arreglo de gates, inicializado para al menos estado->num_pulsos pulsos.
+*/
+void
+restaurar_columnas(const struct EstadoIncremental *estado, struct Gate gates[]){
+	size_t por_gate = cola_estado(estado->num_pulsos, estado->max_lags);
+	size_t inicio_cola = estado->num_pulsos - por_gate;
+	for (int j = 0; j < radar.num_gates; ++j)
+	{
+		memcpy(gates[j].absol_v + inicio_cola, &estado->columnas_v[j*por_gate], sizeof(float) * por_gate);
+		memcpy(gates[j].absol_h + inicio_cola, &estado->columnas_h[j*por_gate], sizeof(float) * por_gate);
+	}
+}
+
+/**
+* @brief Suma a las sumas de cada desplazamiento el aporte de los pulsos nuevos.
+*
+* La suma del desplazamiento i es la de columna[j]*columna[j+i] para todo j.
+* Cada pulso nuevo m aporta el producto columna[m-i]*columna[m] a cada
+* desplazamiento i <= m, por lo que el costo crece con el numero de pulsos
+* nuevos, y no con el cuadrado del total.
+*
+* @param columna[] Columna de modulos del gate, con al menos hasta elementos.
+* @param desde Primer pulso nuevo.
+* @param hasta Numero total de pulsos.
+* @param num_lags Numero de desplazamientos a acumular, como maximo hasta.
+* @param suma[] Sumas sin normalizar de cada desplazamiento, con num_lags elementos.
+*/
+void
+acumular_lags(const float columna[], int desde, int hasta, int num_lags, double suma[]){
+	for (int m = desde; m < hasta; ++m)
+	{
+		double actual = columna[m];
+		for (int i = 0; i <= m && i < num_lags; ++i)
+		{
+			suma[i] += actual * columna[m-i];
+		}
+	}
+}
@@ -0,0 +1,256 @@
+/** @file indice.c
+ *  @brief Indice de pulsos de una captura del radar.
+ *
+ *  Construye, guarda y valida el indice de offsets de una captura. El indice
+ *  se guarda junto a la captura (pulsos.iq.idx) y se reutiliza mientras el
+ *  tamaño y la fecha de modificacion de la captura no cambien, y mientras
+ *  cada pulso respete el maximo de muestras con que se ejecuta el programa.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/radar.h"
+#include "../include/indice.h"
+#include <string.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+struct EncabezadoIndice{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t tamano;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	uint32_t num_pulsos;
+	uint32_t reservado;
+};
+/*!< Encabezado del archivo de indice. Identifica la captura indexada
+por su tamaño y su fecha de modificacion. */
+
+/**
+* @brief Arma el nombre del archivo de indice de una captura.
+*
+* @param file_name[] Nombre de la captura.
+* @return Nombre del archivo de indice, reservado con safe_malloc.
+*/
+static char *
+nombre_indice(char file_name[]){
+	char *nombre = safe_malloc(strlen(file_name) + strlen(INDICE_EXTENSION) + 1);
+	strcpy(nombre, file_name);
+	strcat(nombre, INDICE_EXTENSION);
+	return nombre;
+}
+
+/**
+* @brief Valida las entradas de un indice contra la captura.
+*
+* Cada pulso debe tener a lo sumo radar.max_muestras muestras (que puede ser
+* otro que al construir el indice, con -x), comenzar donde termina el
+* anterior, y el ultimo debe terminar al final de la captura.
+*
+* @param indice Indice a validar.
+* @param tamano Tamaño de la captura en bytes.
+* @return 1 si alguna entrada no es valida, 0 caso contrario.
+*/
+static int
+validar_indice(const struct IndicePulsos *indice, uint64_t tamano){
+	uint64_t offset = 0;
+	for (int i = 0; i < indice->num_pulsos; ++i)
+	{
+		if(indice->valid_samples[i] > radar.max_muestras || indice->offsets[i] != offset){
+			return 1;
+		}
+		offset += sizeof(uint16_t) + indice->valid_samples[i]*4*sizeof(float);
+	}
+	return offset != tamano;
+}
+
+/**
+* @brief Intenta cargar el indice guardado de una captura.
+*
+* El numero de pulsos del encabezado se acota por el tamaño de la captura antes
+* de reservar memoria, para que un indice corrupto se reconstruya en lugar de
+* abortar el programa.
+*
+* @param file_name[] Nombre del archivo de indice.
+* @param st Datos de la captura, para validar que el indice le corresponda.
+* @param indice Estructura donde cargar el indice.
+* @return 1 si no existe, no corresponde a la captura o tiene entradas invalidas, 0 caso contrario.
+*/
+static int
+cargar_indice(char file_name[], const struct stat *st, struct IndicePulsos *indice){
+	struct EncabezadoIndice encabezado;
+	FILE *f = fopen(file_name, "rb");
+	if(!f){
+		return 1;
+	}
+	if(fread(&encabezado, sizeof(encabezado), 1, f) != 1
+		|| encabezado.magic != INDICE_MAGIC
+		|| encabezado.version != INDICE_VERSION
+		|| encabezado.tamano != (uint64_t)st->st_size
+		|| encabezado.mtime_sec != (int64_t)st->st_mtim.tv_sec
+		|| encabezado.mtime_nsec != (int64_t)st->st_mtim.tv_nsec
+		|| encabezado.num_pulsos > encabezado.tamano / sizeof(uint16_t)
+		|| encabezado.num_pulsos > INT_MAX){
+		fclose(f);
+		return 1;
+	}
+
+	indice->num_pulsos = encabezado.num_pulsos;
+	indice->offsets = safe_malloc(sizeof(uint64_t) * indice->num_pulsos);
+	indice->valid_samples = safe_malloc(sizeof(uint16_t) * indice->num_pulsos);
+	if(fread(indice->offsets, sizeof(uint64_t), indice->num_pulsos, f) != (size_t)indice->num_pulsos
+		|| fread(indice->valid_samples, sizeof(uint16_t), indice->num_pulsos, f) != (size_t)indice->num_pulsos
+		|| validar_indice(indice, encabezado.tamano) != 0){
+		liberar_indice(indice);
+		fclose(f);
+		return 1;
+	}
+	fclose(f);
+	return 0;
+}
+
+/**
+* @brief Guarda el indice de una captura en su archivo auxiliar.
+*
+* @param file_name[] Nombre del archivo de indice.
+* @param st Datos de la captura indexada.
+* @param indice Indice a guardar.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+static int
+guardar_indice(char file_name[], const struct stat *st, const struct IndicePulsos *indice){
+	struct EncabezadoIndice encabezado = {
+		INDICE_MAGIC, INDICE_VERSION, st->st_size,
+		st->st_mtim.tv_sec, st->st_mtim.tv_nsec, indice->num_pulsos, 0
+	};
+	FILE *f = fopen(file_name, "wb");
+	if(!f){
+		return 1;
+	}
+	if(fwrite(&encabezado, sizeof(encabezado), 1, f) != 1
+		|| fwrite(indice->offsets, sizeof(uint64_t), indice->num_pulsos, f) != (size_t)indice->num_pulsos
+		|| fwrite(indice->valid_samples, sizeof(uint16_t), indice->num_pulsos, f) != (size_t)indice->num_pulsos){
+		fclose(f);
+		remove(file_name);
+		return 1;
+	}
+	fclose(f);
+	return 0;
+}
+
+/**
+* @brief Recorre una vez la captura y arma su indice.
+*
+* Lee unicamente el encabezado valid_samples de cada pulso y salta su tabla,
+* igual que leer_numero_pulsos_archivo(), guardando el offset de cada uno.
+* Un pulso con mas de radar.max_muestras muestras es un error, como en
+* leer_archivo(), y no se guarda el indice.
+*
+* @param file_name[] El nombre de la captura.
+* @param tamano Tamaño de la captura en bytes.
+* @param indice Estructura donde guardar el indice.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+static int
+construir_indice(char file_name[], long tamano, struct IndicePulsos *indice){
+	FILE *ptr;
+	uint16_t valid_samples;
+	int capacidad = 1024;
+
+	ptr = fopen(file_name, "rb");
+	if(!ptr){
+		printf(BOLDRED"Unable to open file!\n"RESET);
+		return 1;
+	}
+
+	indice->num_pulsos = 0;
+	indice->offsets = safe_malloc(sizeof(uint64_t) * capacidad);
+	indice->valid_samples = safe_malloc(sizeof(uint16_t) * capacidad);
+
+	long offset = 0;
+	while(offset < tamano){
+		if(fread(&valid_samples, sizeof(uint16_t), 1, ptr) != 1
+			|| valid_samples > radar.max_muestras
+			|| fseek(ptr, valid_samples*4*sizeof(float), SEEK_CUR) != 0){
+			printf(BOLDRED"Error recorriendo archivo\n"RESET);
+			liberar_indice(indice);
+			fclose(ptr);
+			return 1;
+		}
+		if(indice->num_pulsos == capacidad){
+			capacidad *= 2;
+			indice->offsets = realloc(indice->offsets, sizeof(uint64_t) * capacidad);
+			indice->valid_samples = realloc(indice->valid_samples, sizeof(uint16_t) * capacidad);
+			if(indice->offsets == NULL || indice->valid_samples == NULL){
+				fprintf(stderr, "Fatal: failed to grow pulse index.\n");
+				exit(EXIT_FAILURE);
+			}
+		}
+		indice->offsets[indice->num_pulsos] = offset;
+		indice->valid_samples[indice->num_pulsos] = valid_samples;
+		indice->num_pulsos++;
+		offset += sizeof(uint16_t) + valid_samples*4*sizeof(float);
+	}
+
+	fclose(ptr);
+	if(offset != tamano){
+		printf(BOLDRED"Archivo de pulsos truncado\n"RESET);
+		liberar_indice(indice);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+* @brief Obtiene el indice de pulsos de una captura.
+*
+* Si existe un indice guardado cuyo tamaño y fecha de modificacion coinciden
+* con los de la captura, lo carga. Si no, recorre la captura una vez, arma el
+* indice y lo guarda para las proximas ejecuciones. No poder guardarlo no es
+* un error: solo se avisa al usuario.
+*
+* @param file_name[] El nombre de la captura.
+* @param indice Estructura donde guardar el indice.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+obtener_indice(char file_name[], struct IndicePulsos *indice){
+	struct stat st;
+	if(stat(file_name, &st) != 0){
+		printf(BOLDRED"Unable to open file!\n"RESET);
+		return 1;
+	}
+
+	char *archivo_indice = nombre_indice(file_name);
+	if(cargar_indice(archivo_indice, &st, indice) == 0){
+		printf("Usando indice "BOLDGREEN"'%s'"RESET"\n", archivo_indice);
+	}
+	else{
+		printf("Construyendo indice de "BOLDGREEN"'%s'"RESET"...\n", file_name);
+		if(construir_indice(file_name, st.st_size, indice) != 0){
+			free(archivo_indice);
+			return 1;
+		}
+		if(guardar_indice(archivo_indice, &st, indice) != 0){
+			printf(BOLDYELLOW"No se pudo guardar el indice en '%s'\n"RESET, archivo_indice);
+		}
+	}
+	free(archivo_indice);
+
+	printf("Se encontró informacion de "BOLDGREEN"%d"RESET" pulsos.\n", indice->num_pulsos);
+	return 0;
+}
+
+/**
+* @brief Libera la memoria de un indice.
+*
+* @param indice Indice obtenido con obtener_indice().
+*/
+void
+liberar_indice(struct IndicePulsos *indice){
+	free(indice->offsets);
+	free(indice->valid_samples);
+	indice->offsets = NULL;
+	indice->valid_samples = NULL;
+	indice->num_pulsos = 0;
+}
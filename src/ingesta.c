@@ -0,0 +1,357 @@
+/** @file ingesta.c
+ *  @brief Lectura asincrona de capturas completas con lecturas grandes en vuelo.
+ *
+ *  io_uring se usa a traves de sus syscalls, sin liburing: se mapean las
+ *  colas de pedidos (SQ) y de resultados (CQ) compartidas con el kernel y se
+ *  encolan lecturas IORING_OP_READ. Si io_uring no esta disponible (kernel
+ *  viejo, seccomp) se usa un grupo de hilos con pread; si O_DIRECT falla, se
+ *  repite la lectura con el archivo abierto normalmente.
+ *
+ *  @author Facundo Maero
+ */
+#define _GNU_SOURCE
+#include "../include/radar.h"
+#include "../include/ingesta.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+struct Uring{
+	int fd;
+	unsigned *sq_cabeza, *sq_cola, *sq_mascara, *sq_arreglo;
+	unsigned *cq_cabeza, *cq_cola, *cq_mascara;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_mapeo, *cq_mapeo;
+	size_t sq_largo, cq_largo, sqes_largo;
+};
+/*!< Instancia de io_uring: las colas mapeadas y los punteros a sus campos. */
+
+struct TrabajoPread{
+	int fd;
+	unsigned char *buffer;
+	size_t tamano;
+	atomic_size_t siguiente;
+	atomic_int error;
+};
+/*!< Lectura compartida por los hilos del respaldo con pread. Cada hilo toma
+el proximo bloque con un fetch_add sobre siguiente. */
+
+/**
+* @brief Indica si una captura puede leerse completa a memoria.
+*
+* El buffer de ingerir_archivo() ocupa lo mismo que la captura, y debe
+* convivir con la matriz de gates. Una captura mas grande que
+* 1/INGESTA_FRACCION_MEMORIA de la memoria fisica se mapea en su lugar, para
+* no depender del swap ni del OOM killer.
+*
+* @param tamano Tamaño de la captura en bytes.
+* @return 1 si entra, 0 caso contrario. Si no se puede consultar la memoria, 1.
+*/
+int
+entra_en_memoria(size_t tamano){
+	long paginas = sysconf(_SC_PHYS_PAGES), pagina = sysconf(_SC_PAGESIZE);
+	if(paginas <= 0 || pagina <= 0){
+		return 1;
+	}
+	return tamano <= (size_t)paginas * pagina / INGESTA_FRACCION_MEMORIA;
+}
+
+/**
+* @brief Largo de la lectura del bloque que comienza en offset.
+*
+* Con O_DIRECT el largo tambien debe ser multiplo de INGESTA_ALINEACION, por
+* lo que el ultimo bloque se redondea hacia arriba; el kernel devuelve solo
+* los bytes hasta el final del archivo.
+*/
+static size_t
+largo_bloque(size_t offset, size_t tamano){
+	size_t fin = (tamano + INGESTA_ALINEACION - 1) & ~(size_t)(INGESTA_ALINEACION - 1);
+	return fin - offset < INGESTA_BLOQUE ? fin - offset : INGESTA_BLOQUE;
+}
+
+/**
+* @brief Crea una instancia de io_uring y mapea sus colas.
+*
+* @param uring Estructura a inicializar.
+* @param entradas Numero de pedidos que pueden estar en vuelo.
+* @return 1 si io_uring no esta disponible, 0 caso contrario.
+*/
+static int
+crear_uring(struct Uring *uring, unsigned entradas){
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+
+	uring->fd = syscall(__NR_io_uring_setup, entradas, &p);
+	if(uring->fd < 0){
+		return 1;
+	}
+
+	uring->sq_largo = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	uring->cq_largo = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if(p.features & IORING_FEAT_SINGLE_MMAP){
+		if(uring->cq_largo > uring->sq_largo) uring->sq_largo = uring->cq_largo;
+		uring->cq_largo = uring->sq_largo;
+	}
+	uring->sqes_largo = p.sq_entries * sizeof(struct io_uring_sqe);
+
+	uring->sq_mapeo = mmap(NULL, uring->sq_largo, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQ_RING);
+	uring->cq_mapeo = (p.features & IORING_FEAT_SINGLE_MMAP) ? uring->sq_mapeo :
+		mmap(NULL, uring->cq_largo, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_CQ_RING);
+	void *sqes = mmap(NULL, uring->sqes_largo, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd, IORING_OFF_SQES);
+	if(uring->sq_mapeo == MAP_FAILED || uring->cq_mapeo == MAP_FAILED || sqes == MAP_FAILED){
+		if(uring->sq_mapeo != MAP_FAILED) munmap(uring->sq_mapeo, uring->sq_largo);
+		if(uring->cq_mapeo != MAP_FAILED && uring->cq_mapeo != uring->sq_mapeo) munmap(uring->cq_mapeo, uring->cq_largo);
+		if(sqes != MAP_FAILED) munmap(sqes, uring->sqes_largo);
+		close(uring->fd);
+		return 1;
+	}
+
+	unsigned char *sq = uring->sq_mapeo, *cq = uring->cq_mapeo;
+	uring->sq_cabeza = (unsigned *)(sq + p.sq_off.head);
+	uring->sq_cola = (unsigned *)(sq + p.sq_off.tail);
+	uring->sq_mascara = (unsigned *)(sq + p.sq_off.ring_mask);
+	uring->sq_arreglo = (unsigned *)(sq + p.sq_off.array);
+	uring->cq_cabeza = (unsigned *)(cq + p.cq_off.head);
+	uring->cq_cola = (unsigned *)(cq + p.cq_off.tail);
+	uring->cq_mascara = (unsigned *)(cq + p.cq_off.ring_mask);
+	uring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+	uring->sqes = sqes;
+	return 0;
+}
+
+/**
+* @brief Desmapea las colas y cierra una instancia de io_uring.
+*/
+static void
+cerrar_uring(struct Uring *uring){
+	munmap(uring->sqes, uring->sqes_largo);
+	if(uring->cq_mapeo != uring->sq_mapeo) munmap(uring->cq_mapeo, uring->cq_largo);
+	munmap(uring->sq_mapeo, uring->sq_largo);
+	close(uring->fd);
+}
+
+/**
+* @brief Encola una lectura en la SQ. Se envia al kernel en el proximo io_uring_enter.
+*
+* user_data guarda el offset (40 bits) y el largo (24 bits) del pedido, para
+* ubicarlo al recibir su resultado.
+*/
+static void
+encolar_lectura(struct Uring *uring, int fd, unsigned char *buffer, size_t offset, size_t largo){
+	unsigned cola = *uring->sq_cola;
+	unsigned indice = cola & *uring->sq_mascara;
+	struct io_uring_sqe *sqe = &uring->sqes[indice];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = fd;
+	sqe->addr = (uintptr_t)(buffer + offset);
+	sqe->len = largo;
+	sqe->off = offset;
+	sqe->user_data = ((uint64_t)largo << 40) | offset;
+	uring->sq_arreglo[indice] = indice;
+	__atomic_store_n(uring->sq_cola, cola + 1, __ATOMIC_RELEASE);
+	//el kernel ve el pedido recien con la nueva cola
+}
+
+/**
+* @brief Lee el archivo completo con io_uring, con INGESTA_EN_VUELO lecturas pendientes.
+*
+* Cada resultado corto que no llega al final del archivo se vuelve a encolar
+* por el resto del bloque.
+*
+* @param fd Archivo abierto.
+* @param buffer Buffer alineado de al menos tamano bytes redondeado a INGESTA_ALINEACION.
+* @param tamano Tamaño del archivo.
+* @return 1 si io_uring no esta disponible o alguna lectura fallo, 0 caso contrario.
+*/
+static int
+leer_uring(int fd, unsigned char *buffer, size_t tamano){
+	struct Uring uring;
+	size_t siguiente = 0;
+	unsigned en_vuelo = 0, por_enviar = 0;
+	int error = 0;
+
+	if(tamano >= ((size_t)1 << 40) || crear_uring(&uring, INGESTA_EN_VUELO) != 0){
+		return 1;
+		//user_data guarda offset y largo en 40 y 24 bits
+	}
+
+	while(!error && (siguiente < tamano || en_vuelo > 0)){
+		while(siguiente < tamano && en_vuelo < INGESTA_EN_VUELO){
+			size_t largo = largo_bloque(siguiente, tamano);
+			encolar_lectura(&uring, fd, buffer, siguiente, largo);
+			siguiente += largo;
+			en_vuelo++;
+			por_enviar++;
+		}
+
+		int r = syscall(__NR_io_uring_enter, uring.fd, por_enviar, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+		if(r < 0){
+			if(errno == EINTR) continue;
+			error = 1;
+			break;
+		}
+		por_enviar -= r < (int)por_enviar ? r : por_enviar;
+
+		unsigned cabeza = *uring.cq_cabeza;
+		while(cabeza != __atomic_load_n(uring.cq_cola, __ATOMIC_ACQUIRE)){
+			struct io_uring_cqe *cqe = &uring.cqes[cabeza & *uring.cq_mascara];
+			size_t offset = cqe->user_data & (((uint64_t)1 << 40) - 1);
+			size_t largo = cqe->user_data >> 40;
+			en_vuelo--;
+
+			if(cqe->res < 0){
+				error = 1;
+			}
+			else if((size_t)cqe->res < largo && offset + cqe->res < tamano){
+				if(cqe->res == 0){
+					error = 1;
+					//el archivo se achico durante la lectura
+				}
+				else{
+					encolar_lectura(&uring, fd, buffer, offset + cqe->res, largo - cqe->res);
+					en_vuelo++;
+					por_enviar++;
+				}
+			}
+			cabeza++;
+		}
+		__atomic_store_n(uring.cq_cabeza, cabeza, __ATOMIC_RELEASE);
+	}
+
+	if(error && en_vuelo > 0){
+		//espera los pedidos pendientes antes de liberar el buffer al que escriben
+		while(en_vuelo > 0 && syscall(__NR_io_uring_enter, uring.fd, por_enviar, 1, IORING_ENTER_GETEVENTS, NULL, 0) >= 0){
+			unsigned cabeza = *uring.cq_cabeza;
+			por_enviar = 0;
+			while(cabeza != __atomic_load_n(uring.cq_cola, __ATOMIC_ACQUIRE)){
+				cabeza++;
+				en_vuelo--;
+			}
+			__atomic_store_n(uring.cq_cabeza, cabeza, __ATOMIC_RELEASE);
+		}
+	}
+	cerrar_uring(&uring);
+	return error;
+}
+
+/**
+* @brief Hilo del respaldo con pread: lee bloques hasta que no quedan.
+*
+* @param arg Puntero a la struct TrabajoPread compartida.
+* @return NULL.
+*/
+static void *
+leer_bloques_pread(void *arg){
+	struct TrabajoPread *trabajo = arg;
+	size_t offset;
+
+	while(!atomic_load(&trabajo->error)
+		&& (offset = atomic_fetch_add(&trabajo->siguiente, INGESTA_BLOQUE)) < trabajo->tamano){
+		size_t largo = largo_bloque(offset, trabajo->tamano);
+		size_t hecho = 0;
+
+		while(hecho < largo && offset + hecho < trabajo->tamano){
+			ssize_t r = pread(trabajo->fd, trabajo->buffer + offset + hecho, largo - hecho, offset + hecho);
+			if(r < 0 && errno == EINTR){
+				continue;
+			}
+			if(r <= 0){
+				atomic_store(&trabajo->error, 1);
+				break;
+			}
+			hecho += r;
+		}
+	}
+	return NULL;
+}
+
+/**
+* @brief Lee el archivo completo con INGESTA_EN_VUELO hilos que hacen pread.
+*
+* @param fd Archivo abierto.
+* @param buffer Buffer alineado de al menos tamano bytes redondeado a INGESTA_ALINEACION.
+* @param tamano Tamaño del archivo.
+* @return 1 si alguna lectura fallo, 0 caso contrario.
+*/
+static int
+leer_pread(int fd, unsigned char *buffer, size_t tamano){
+	struct TrabajoPread trabajo = {.fd = fd, .buffer = buffer, .tamano = tamano};
+	pthread_t hilos[INGESTA_EN_VUELO];
+	int creados = 0;
+
+	atomic_init(&trabajo.siguiente, 0);
+	atomic_init(&trabajo.error, 0);
+	while(creados < INGESTA_EN_VUELO && pthread_create(&hilos[creados], NULL, leer_bloques_pread, &trabajo) == 0){
+		creados++;
+	}
+	if(creados == 0){
+		leer_bloques_pread(&trabajo);
+	}
+	for (int i = 0; i < creados; ++i)
+	{
+		pthread_join(hilos[i], NULL);
+	}
+	return atomic_load(&trabajo.error);
+}
+
+/**
+* @brief Lee una captura completa en un buffer alineado.
+*
+* Intenta primero con el archivo abierto con O_DIRECT y luego sin el; en cada
+* caso, primero con io_uring y luego con pread en paralelo.
+*
+* @param file_name[] El nombre del archivo a leer.
+* @param tamano Puntero para retornar el tamaño del archivo.
+* @param metodo Puntero para retornar una descripcion del metodo de lectura usado.
+* @return Buffer con el contenido del archivo, reservado con mmap (liberar con
+* munmap de tamano bytes), o NULL si hubo un error.
+*/
+void *
+ingerir_archivo(char file_name[], size_t *tamano, const char **metodo){
+	static const char *metodos[2][2] = {{"io_uring, O_DIRECT", "pread, O_DIRECT"}, {"io_uring", "pread"}};
+	struct stat st;
+
+	if(stat(file_name, &st) != 0 || st.st_size == 0){
+		printf(BOLDRED"Error leyendo tamaño del archivo\n"RESET);
+		return NULL;
+	}
+	*tamano = st.st_size;
+	size_t largo = (*tamano + INGESTA_ALINEACION - 1) & ~(size_t)(INGESTA_ALINEACION - 1);
+
+	unsigned char *buffer = mmap(NULL, largo, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(buffer == MAP_FAILED){
+		printf(BOLDRED"Error reservando buffer de lectura\n"RESET);
+		return NULL;
+	}
+
+	for (int intento = 0; intento < 2; ++intento)
+	{
+		int fd = open(file_name, O_RDONLY | (intento == 0 ? O_DIRECT : 0));
+		if(fd < 0){
+			continue;
+		}
+		for (int via = 0; via < 2; ++via)
+		{
+			if((via == 0 ? leer_uring(fd, buffer, *tamano) : leer_pread(fd, buffer, *tamano)) == 0){
+				close(fd);
+				*metodo = metodos[intento][via];
+				return buffer;
+			}
+		}
+		close(fd);
+	}
+
+	printf(BOLDRED"Error leyendo archivo\n"RESET);
+	munmap(buffer, largo);
+	return NULL;
+}
@@ -0,0 +1,236 @@
+/** @file lote.c
+ *  @brief Lote de capturas a procesar en una misma ejecucion.
+ *
+ *  Arma la lista de capturas a partir de un directorio (todos los archivos
+ *  LOTE_EXTENSION) o de un archivo de texto con una ruta por linea, y decide
+ *  el orden en que se procesan.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/radar.h"
+#include "../include/lote.h"
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+* @brief Agrega una captura al lote, si existe y es un archivo regular.
+*
+* @param lote Lote en construccion.
+* @param capacidad Puntero a la capacidad de los arreglos del lote, que crecen al doble.
+* @param ruta Ruta de la captura. Se copia.
+* @return 1 si la captura no existe o no es un archivo regular, 0 caso contrario.
+*/
+static int
+agregar_captura(struct Lote *lote, int *capacidad, const char ruta[]){
+	struct stat st;
+	if(stat(ruta, &st) != 0 || !S_ISREG(st.st_mode)){
+		printf(BOLDYELLOW"Se ignora la captura '%s'\n"RESET, ruta);
+		return 1;
+	}
+	if(lote->num_capturas == *capacidad){
+		*capacidad = *capacidad > 0 ? 2 * *capacidad : 16;
+		char **rutas = realloc(lote->rutas, sizeof(char *) * *capacidad);
+		uint64_t *bytes = realloc(lote->bytes, sizeof(uint64_t) * *capacidad);
+		if(!rutas || !bytes){
+			fprintf(stderr, "Fatal: failed to allocate batch list.\n");
+			exit(EXIT_FAILURE);
+		}
+		lote->rutas = rutas;
+		lote->bytes = bytes;
+	}
+	lote->rutas[lote->num_capturas] = safe_malloc(strlen(ruta) + 1);
+	strcpy(lote->rutas[lote->num_capturas], ruta);
+	lote->bytes[lote->num_capturas] = st.st_size;
+	lote->num_capturas++;
+	return 0;
+}
+
+/**
+* @brief Agrega al lote las capturas de un directorio.
+*
+* @param lote Lote en construccion.
+* @param capacidad Puntero a la capacidad de los arreglos del lote.
+* @param directorio Ruta del directorio.
+* @return 1 si no pudo abrirse el directorio, 0 caso contrario.
+*/
+static int
+leer_directorio(struct Lote *lote, int *capacidad, const char directorio[]){
+	DIR *dir = opendir(directorio);
+	struct dirent *entrada;
+	size_t largo_extension = strlen(LOTE_EXTENSION);
+
+	if(!dir){
+		return 1;
+	}
+	while((entrada = readdir(dir)) != NULL){
+		size_t largo = strlen(entrada->d_name);
+		if(largo <= largo_extension
+			|| strcmp(entrada->d_name + largo - largo_extension, LOTE_EXTENSION) != 0){
+			continue;
+		}
+		char *ruta = safe_malloc(strlen(directorio) + largo + 2);
+		sprintf(ruta, "%s/%s", directorio, entrada->d_name);
+		agregar_captura(lote, capacidad, ruta);
+		free(ruta);
+	}
+	closedir(dir);
+	return 0;
+}
+
+/**
+* @brief Agrega al lote las capturas de un archivo de texto, una ruta por linea.
+*
+* Se ignoran las lineas vacias y las que comienzan con '#'.
+*
+* @param lote Lote en construccion.
+* @param capacidad Puntero a la capacidad de los arreglos del lote.
+* @param lista Ruta del archivo con la lista.
+* @return 1 si no pudo abrirse la lista, 0 caso contrario.
+*/
+static int
+leer_lista(struct Lote *lote, int *capacidad, const char lista[]){
+	char linea[4096];
+	FILE *f = fopen(lista, "r");
+
+	if(!f){
+		return 1;
+	}
+	while(fgets(linea, sizeof(linea), f) != NULL){
+		linea[strcspn(linea, "\r\n")] = '\0';
+		if(linea[0] == '\0' || linea[0] == '#'){
+			continue;
+		}
+		agregar_captura(lote, capacidad, linea);
+	}
+	fclose(f);
+	return 0;
+}
+
+struct CapturaLote{
+	char *ruta;
+	uint64_t bytes;
+};
+/*!< Captura del lote, para ordenarlas con qsort. */
+
+/**
+* @brief Orden del lote: primero las capturas mas grandes, y a igual tamaño por nombre.
+*/
+static int
+comparar_capturas(const void *a, const void *b){
+	const struct CapturaLote *x = a, *y = b;
+	if(x->bytes != y->bytes){
+		return x->bytes > y->bytes ? -1 : 1;
+	}
+	return strcmp(x->ruta, y->ruta);
+}
+
+/**
+* @brief Arma el lote de capturas a procesar.
+*
+* Si origen es un directorio, toma todos sus archivos con extension
+* LOTE_EXTENSION; si no, lo lee como una lista de rutas. Las capturas se
+* ordenan de mayor a menor tamaño: la matriz de gates se reserva para la
+* primera y alcanza, salvo capturas con muchos pulsos cortos, para todas las
+* siguientes.
+*
+* @param origen[] Directorio o lista de capturas.
+* @param lote Lote a inicializar. Debe liberarse con liberar_lote().
+* @return 1 si no pudo leerse el origen, 0 caso contrario.
+*/
+int
+crear_lote(char origen[], struct Lote *lote){
+	struct stat st;
+	int capacidad = 0;
+
+	lote->num_capturas = 0;
+	lote->rutas = NULL;
+	lote->bytes = NULL;
+
+	int error = (stat(origen, &st) == 0 && S_ISDIR(st.st_mode)) ?
+		leer_directorio(lote, &capacidad, origen) :
+		leer_lista(lote, &capacidad, origen);
+	if(error){
+		liberar_lote(lote);
+		return 1;
+	}
+
+	struct CapturaLote *capturas = safe_malloc(sizeof(struct CapturaLote) * (lote->num_capturas + 1));
+	for (int i = 0; i < lote->num_capturas; ++i)
+	{
+		capturas[i].ruta = lote->rutas[i];
+		capturas[i].bytes = lote->bytes[i];
+	}
+	qsort(capturas, lote->num_capturas, sizeof(struct CapturaLote), comparar_capturas);
+	for (int i = 0; i < lote->num_capturas; ++i)
+	{
+		lote->rutas[i] = capturas[i].ruta;
+		lote->bytes[i] = capturas[i].bytes;
+	}
+	free(capturas);
+	return 0;
+}
+
+/**
+* @brief Libera un lote de capturas.
+*
+* @param lote Lote creado con crear_lote().
+*/
+void
+liberar_lote(struct Lote *lote){
+	for (int i = 0; i < lote->num_capturas; ++i)
+	{
+		free(lote->rutas[i]);
+	}
+	free(lote->rutas);
+	free(lote->bytes);
+	lote->rutas = NULL;
+	lote->bytes = NULL;
+	lote->num_capturas = 0;
+}
+
+/**
+* @brief Arma el nombre del archivo de resultados de una captura del lote.
+*
+* Reemplaza la extension LOTE_EXTENSION de la captura, si la tiene, por
+* "_" y el sufijo: "vol1.iq" con sufijo "out_st.txt" da "vol1_out_st.txt".
+* El resultado no termina en LOTE_EXTENSION, por lo que no se toma como
+* captura si se vuelve a procesar el mismo directorio.
+*
+* @param captura[] Ruta de la captura.
+* @param sufijo[] Nombre del archivo de resultados del modo normal.
+* @return Ruta del archivo de resultados, reservada con safe_malloc.
+*/
+char *
+ruta_salida(const char captura[], const char sufijo[]){
+	size_t largo = strlen(captura);
+	size_t largo_extension = strlen(LOTE_EXTENSION);
+	if(largo > largo_extension && strcmp(captura + largo - largo_extension, LOTE_EXTENSION) == 0){
+		largo -= largo_extension;
+	}
+	char *salida = safe_malloc(largo + strlen(sufijo) + 2);
+	memcpy(salida, captura, largo);
+	salida[largo] = '_';
+	strcpy(salida + largo + 1, sufijo);
+	return salida;
+}
+
+/**
+* @brief Pide al sistema operativo que empiece a leer una captura.
+*
+* Con POSIX_FADV_WILLNEED el kernel trae la captura a la cache de paginas en
+* segundo plano, mientras el programa sigue calculando la captura anterior.
+* Es solo una sugerencia: si falla, la captura se lee normalmente.
+*
+* @param captura[] Ruta de la captura.
+*/
+void
+anticipar_captura(const char captura[]){
+	int fd = open(captura, O_RDONLY);
+	if(fd >= 0){
+		posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+		close(fd);
+	}
+}
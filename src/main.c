@@ -0,0 +1,224 @@
+/** @file main.c
+ *  @brief Archivo principal del programa.
+ *
+ *  Se compila un unico binario, build/radar. build/single_threaded y
+ *  build/multithreaded son enlaces a el: invocado como single_threaded usa un
+ *  solo hilo y guarda sus resultados en out_st.txt y times_st.txt, como el
+ *  antiguo programa monothread; con cualquier otro nombre usa out_mt.txt y
+ *  times_mt.txt.
+ *
+ *  @author Facundo Maero
+ */
+
+#include "../include/func_radar.h"
+
+ /**
+* @brief Función main.
+*
+* Función principal del programa que procesa los valores explotando el paralelismo
+* del problema. Los backends de ejecucion, kernels, motor y lectura se eligen al
+* inicio, o al conocer el tamaño de la captura, salvo que se indiquen. 
+* Acepta parametros opcionales: 
+* -t Para medir el tiempo total de ejecucion y mostrarlo por salida standard.
+* -s Para guardar en un archivo la medición realizada, y el número de hilos utilizado.
+* -m Para leer el archivo de pulsos mapeandolo en memoria, sin copiar las muestras.
+* -u Para leer el archivo de pulsos completo con lecturas grandes asincronas (io_uring, O_DIRECT).
+* -r <lectura> Para elegir el metodo de lectura: "auto", "fread", "mmap" o "asincrona".
+* -i Para usar el indice de pulsos de la captura en lugar de recorrerla.
+* -f Para procesar los pulsos en flujo, sin guardar toda la captura en memoria.
+* -p Para procesar los pulsos mientras un hilo lector los lee, sin esperar a leer toda la captura.
+* -c Para procesar solo los pulsos agregados a la captura desde la ultima ejecucion.
+* -w <M> <K> Para procesar en tiempo real los pulsos de la entrada estandar, con una ventana de M pulsos.
+* -d <ms> Para fijar, con -w, la latencia maxima admitida por bloque.
+* -o Para escribir cada gate en su lugar del archivo de resultados apenas se calcula.
+* -e <formato> Para elegir el formato del archivo de resultados: "v1", "f32", "f16" o "xor".
+* -g <gates> Para indicar el numero de gates del radar.
+* -x <muestras> Para indicar el numero maximo de muestras por pulso.
+* -l <L> Para calcular y guardar solo los desplazamientos 0 a L de la autocorrelacion.
+* -b <lote> Para procesar todas las capturas de un directorio o de una lista, con un archivo de resultados por captura.
+* -a <motor> Para elegir el motor de autocorrelacion: "auto", "directo", "fft" o "simd".
+* -k <kernels> Para elegir los kernels vectoriales: "auto", "avx512", "avx2", "sse" o "escalar".
+* <nro_hilos> Para configurar el número de hilos a utilizar. Por defecto, todos los disponibles.
+*/
+int 
+main(int argc, char *argv[])
+{
+	double start_time = omp_get_wtime();
+	struct Opciones opciones = {0};
+	int cant_pulsos_archivo;
+	uint64_t tamano_archivo_bytes;
+	const char *programa = strrchr(argv[0], '/') != NULL ? strrchr(argv[0], '/') + 1 : argv[0];
+	int monohilo = strcmp(programa, "single_threaded") == 0;
+	char *archivo_salida = monohilo ? "out_st.txt" : "out_mt.txt";
+	char *archivo_tiempos = monohilo ? "times_st.txt" : "times_mt.txt";
+
+	opciones.num_threads = omp_get_max_threads();
+	process_arguments(argc, argv, &opciones);
+	if(monohilo){
+		opciones.num_threads = 1;
+	}
+	struct Gate gates[radar.num_gates];
+	omp_set_num_threads(opciones.num_threads);
+
+	printf("Ejecutando el codigo con "BOLDGREEN"%d"RESET" hilos (%s).\n", omp_get_max_threads(), nombre_ejecucion(omp_get_max_threads()));
+	printf("Kernels SIMD: "BOLDGREEN"%s"RESET"\n", inicializar_simd(opciones.kernels));
+
+	if(opciones.ventana > 0){
+		initialize_gates(gates, opciones.ventana);
+		if(procesar_ventana(stdin, gates, opciones.ventana, opciones.paso, opciones.plazo, opciones.num_lags, opciones.formato, archivo_salida) != 0){
+			printf(BOLDRED"Error procesando flujo de pulsos\n"RESET);
+			exit(EXIT_FAILURE);
+		}
+		free_gates(gates, opciones.ventana);
+		printf("Bloques guardados en "BOLDGREEN"'%s'\n"RESET, archivo_salida);
+		return 0;
+	}
+
+	if(opciones.lote != NULL){
+		struct Lote lote;
+		if(crear_lote(opciones.lote, &lote) != 0){
+			printf(BOLDRED"Error leyendo lote de capturas '%s'\n"RESET, opciones.lote);
+			exit(EXIT_FAILURE);
+		}
+		int errores = procesar_lote(&lote, gates, &opciones, archivo_salida);
+		printf("Capturas procesadas: "BOLDGREEN"%d/%d"RESET"\n", lote.num_capturas - errores, lote.num_capturas);
+		liberar_lote(&lote);
+		if(opciones.time_flag){
+			printf ("Tiempo total = "BOLDGREEN"%f"RESET" segundos\n", omp_get_wtime() - start_time);
+		}
+		return errores > 0 ? EXIT_FAILURE : 0;
+	}
+
+	struct IndicePulsos indice = {0};
+	if(opciones.indice_flag && obtener_indice("pulsos.iq", &indice) != 0){
+		printf(BOLDRED"Error obteniendo indice de pulsos\n"RESET);
+		exit(EXIT_FAILURE);
+	}
+
+	int lectura = opciones.lectura;
+	if(lectura == LECTURA_AUTO && !opciones.incremental_flag && !opciones.flujo_flag && !opciones.pipeline_flag){
+		lectura = elegir_lectura(lectura, "pulsos.iq");
+		printf("Lectura de la captura: "BOLDGREEN"%s"RESET"\n", nombre_lectura(lectura));
+	}
+
+	struct EstadoIncremental estado = {0};
+	if(opciones.incremental_flag){
+		if(leer_archivo_incremental("pulsos.iq", gates, opciones.num_lags, &estado, &cant_pulsos_archivo) != 0){
+			printf(BOLDRED"Error procesando pulsos nuevos\n"RESET);
+			exit(EXIT_FAILURE);
+		}
+	}
+	else if(lectura == LECTURA_MMAP || lectura == LECTURA_ASINCRONA){
+		struct Captura captura;
+		int error_captura;
+		REGION(REGION_LECTURA){
+			error_captura = lectura == LECTURA_ASINCRONA ?
+				cargar_captura("pulsos.iq", opciones.indice_flag ? &indice : NULL, &captura) :
+				abrir_captura("pulsos.iq", opciones.indice_flag ? &indice : NULL, &captura);
+		}
+		if(error_captura != 0){
+			printf(BOLDRED"Error cargando archivo de pulsos\n"RESET);
+			exit(EXIT_FAILURE);
+		}
+		cant_pulsos_archivo = captura.num_pulsos;
+		initialize_gates(gates, cant_pulsos_archivo);
+		REGION(REGION_MODULO) promedio_y_valor_absoluto_captura(&captura, gates);
+		cerrar_captura(&captura);
+	}
+	else{
+		if(opciones.indice_flag){
+			cant_pulsos_archivo = indice.num_pulsos;
+		}
+		else if(leer_numero_pulsos_archivo("pulsos.iq", &cant_pulsos_archivo, &tamano_archivo_bytes) != 0){
+			printf(BOLDRED"Error leyendo numero de pulsos en archivo\n"RESET);
+			exit(EXIT_FAILURE);
+		}
+
+		initialize_gates(gates, cant_pulsos_archivo);
+
+		if(opciones.pipeline_flag){
+			if(procesar_archivo_pipeline("pulsos.iq", gates, cant_pulsos_archivo) != 0){
+				printf(BOLDRED"Error procesando archivo con hilo lector\n"RESET);
+				exit(EXIT_FAILURE);
+			}
+		}
+		else if(opciones.flujo_flag){
+			if(procesar_archivo_flujo("pulsos.iq", gates, cant_pulsos_archivo) != 0){
+				printf(BOLDRED"Error procesando archivo en flujo\n"RESET);
+				exit(EXIT_FAILURE);
+			}
+		}
+		else{
+			struct AlmacenPulsos almacen;
+			int error_lectura;
+
+			REGION(REGION_LECTURA){
+				error_lectura = opciones.indice_flag ?
+					leer_archivo_indice("pulsos.iq", &almacen, &indice) :
+					leer_archivo("pulsos.iq", &almacen, cant_pulsos_archivo, tamano_archivo_bytes);
+			}
+			if(error_lectura != 0){
+				printf(BOLDRED"Error leer_archivo\n"RESET);
+				exit(EXIT_FAILURE);
+			}
+
+			REGION(REGION_MODULO) promedio_y_valor_absoluto(&almacen, gates);
+			liberar_almacen(&almacen);
+		}
+	}
+	liberar_indice(&indice);
+	int num_lags = lags_calculados(cant_pulsos_archivo, opciones.num_lags);
+	struct Formato formato;
+	struct Salida salida;
+	struct Salida *posicional = NULL;
+	preparar_formato(&formato, opciones.formato, cant_pulsos_archivo, num_lags);
+	if(opciones.posicional_flag){
+		if(abrir_salida(&salida, archivo_salida, &formato) != 0){
+			printf(BOLDRED"Error abriendo archivo de resultados\n"RESET);
+			exit(EXIT_FAILURE);
+		}
+		posicional = &salida;
+	}
+	if(opciones.incremental_flag){
+		calcular_autocorrelacion_incremental(gates, &estado, cant_pulsos_archivo, posicional);
+		if(guardar_estado("pulsos.iq", &estado, gates) != 0){
+			printf(BOLDYELLOW"No se pudo guardar el estado incremental\n"RESET);
+		}
+		liberar_estado(&estado);
+	}
+	else{
+		REGION(REGION_AUTOCORRELACION) calcular_autocorrelacion_motor(gates, opciones.motor, cant_pulsos_archivo, num_lags, posicional);
+	}
+
+	free_absolute_values_gates(gates, cant_pulsos_archivo);
+	int error_guardado;
+	REGION(REGION_ESCRITURA){
+		error_guardado = posicional != NULL ?
+			cerrar_salida(posicional) :
+			guardar_archivo(gates, archivo_salida, &formato);
+	}
+	if(error_guardado != 0){
+		printf(BOLDRED"Error guardando archivo\n"RESET);
+		exit(EXIT_FAILURE);
+	}
+
+	printf("Datos guardados en "BOLDGREEN"'%s'\n"RESET, archivo_salida);
+	free_gates(gates, cant_pulsos_archivo);
+
+	double time = omp_get_wtime() - start_time;
+	INFORMAR_CONTADORES();
+	if(opciones.time_flag){
+		printf ("Tiempo total = "BOLDGREEN"%f"RESET" segundos\n",time);
+	}
+	
+	if(opciones.save_flag){
+		if(save_time_to_file(time, opciones.num_threads, archivo_tiempos) != 0){
+			printf(BOLDRED"Error guardando tiempo de ejecucion en archivo\n"RESET);
+			exit(EXIT_FAILURE);
+		}
+		printf("Tiempo guardado en "BOLDGREEN"'%s'\n"RESET, archivo_tiempos);
+	}
+
+	return 0;
+}
+
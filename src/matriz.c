@@ -0,0 +1,100 @@
+/** @file matriz.c
+ *  @brief Arena unica para la matriz de gates.
+ *
+ *  La arena se reserva con mmap, alineada a pagina. Las paginas no se tocan al
+ *  reservarla: quedan en el nodo NUMA del hilo que las escribe primero, lo que
+ *  permite a initialize_gates() ubicar cada gate junto al hilo que calculara
+ *  su autocorrelacion. Por eso la arena solo se marca como candidata a paginas
+ *  enormes con un hilo: una pagina de 2 MiB abarca gates de varios hilos, y
+ *  quedaria entera en el nodo del primero que la toca.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/radar.h"
+#include "../include/matriz.h"
+#include <unistd.h>
+#include <sys/mman.h>
+
+/**
+* @brief Tamaño de la arena en bytes.
+*
+* @param num_pulsos Numero de pulsos de la captura.
+* @return Bytes ocupados por las NUM_REGIONES regiones.
+*/
+static size_t
+tamano_matriz(int num_pulsos){
+	return (size_t)NUM_REGIONES * radar.num_gates * largo_columna(num_pulsos) * sizeof(float);
+}
+
+/**
+* @brief Numero de floats que ocupa cada columna en la arena.
+*
+* Es num_pulsos redondeado hacia arriba a un multiplo de ALINEACION_COLUMNA
+* bytes, para que cada columna comience en su propia linea de cache.
+*
+* @param num_pulsos Numero de pulsos de la captura.
+* @return Separacion en floats entre columnas consecutivas.
+*/
+size_t
+largo_columna(int num_pulsos){
+	size_t por_linea = ALINEACION_COLUMNA / sizeof(float);
+	size_t largo = num_pulsos > 0 ? (size_t)num_pulsos : 1;
+	return (largo + por_linea - 1) / por_linea * por_linea;
+}
+
+/**
+* @brief Reserva la arena de la matriz de gates.
+*
+* Como safe_malloc(), termina el programa si no hay memoria.
+*
+* @param num_pulsos Numero de pulsos de la captura.
+* @param hilos Numero de hilos que escribiran la arena por primera vez.
+* @return Arena sin inicializar (sus paginas se leen como ceros). Debe liberarse
+* con liberar_matriz().
+*/
+float *
+reservar_matriz(int num_pulsos, int hilos){
+	size_t tamano = tamano_matriz(num_pulsos);
+	void *matriz = mmap(NULL, tamano, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(matriz == MAP_FAILED){
+		fprintf(stderr, "Fatal: failed to allocate %zu bytes.\n", tamano);
+		exit(EXIT_FAILURE);
+	}
+#ifdef MADV_HUGEPAGE
+	if(hilos == 1){
+		madvise(matriz, tamano, MADV_HUGEPAGE);
+		//es solo una sugerencia: si el kernel no la soporta, se usan paginas normales
+	}
+#else
+	(void)hilos;
+#endif
+	return matriz;
+}
+
+/**
+* @brief Devuelve al sistema la memoria de las columnas de modulos.
+*
+* Una vez calculada la autocorrelacion, absol_v y absol_h ya no se usan. Como
+* son las dos primeras regiones de la arena, se descartan las paginas que
+* ocupan por completo; la arena sigue reservada hasta liberar_matriz().
+*
+* @param matriz Arena reservada con reservar_matriz().
+* @param num_pulsos Numero de pulsos con que se reservo la arena.
+*/
+void
+descartar_modulos(float *matriz, int num_pulsos){
+	size_t pagina = sysconf(_SC_PAGESIZE);
+	size_t tamano = 2 * tamano_matriz(num_pulsos) / NUM_REGIONES;
+	madvise(matriz, tamano / pagina * pagina, MADV_DONTNEED);
+}
+
+/**
+* @brief Libera la arena de la matriz de gates.
+*
+* @param matriz Arena reservada con reservar_matriz().
+* @param num_pulsos Numero de pulsos con que se reservo la arena.
+*/
+void
+liberar_matriz(float *matriz, int num_pulsos){
+	munmap(matriz, tamano_matriz(num_pulsos));
+}
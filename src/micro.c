@@ -0,0 +1,598 @@
+/** @file micro.c
+ *  @brief Microbenchmarks de los kernels del motor, con modelo roofline.
+ *
+ *  Mide por separado, en un solo hilo y sobre datos sinteticos, los kernels
+ *  de cada etapa: el modulo de las muestras (valor_absoluto() y modulos_iq()),
+ *  el promedio por gate de las tablas crudas, la lectura de las tablas con
+ *  leer_archivo(), la autocorrelacion directa y vectorizada con varios largos,
+ *  y la escritura con guardar_archivo().
+ *
+ *  Antes se miden los techos de la maquina en un nucleo: el pico de calculo,
+ *  con FMAs independientes en el ancho de los kernels elegidos, y el ancho de
+ *  banda a memoria, con la triada de STREAM sobre arreglos mas grandes que la
+ *  cache. Cada kernel se compara con el techo que le corresponde segun su
+ *  intensidad aritmetica (FLOPs por byte): a la izquierda del punto de cruce
+ *  esta limitado por memoria, y a la derecha por calculo.
+ *
+ *  @author Facundo Maero
+ */
+
+#include "../include/func_radar.h"
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MICRO_X86
+#endif
+
+#define TIEMPO_MINIMO_MICRO 0.1
+/*!< Segundos minimos de cada medicion: se repite el kernel hasta alcanzarlos. */
+#define MEDICIONES_MICRO 3
+/*!< Mediciones de cada kernel, salvo que se indique otro numero con -n. Se informa la mejor. */
+#define ITERACIONES_PICO 20000000L
+/*!< Iteraciones del bucle de FMAs que mide el pico de calculo. */
+#define ELEMENTOS_STREAM (8L << 20)
+/*!< Floats de cada arreglo de la triada: 32 MiB, mas que la cache de ultimo nivel. */
+#define MUESTRAS_MODULO (1 << 20)
+/*!< Muestras I/Q de los microbenchmarks de modulo. */
+#define PULSOS_MICRO 200
+/*!< Pulsos de la captura sintetica. */
+#define MUESTRAS_MICRO 4400
+/*!< Muestras por pulso de la captura sintetica, similar a la de ejemplo. */
+#define MAX_KERNELS_MICRO 16
+/*!< Numero maximo de microbenchmarks. */
+
+static const int largos_autocorr[] = {256, 1024, 4096, 16384};
+/*!< Largos de vector de los microbenchmarks de autocorrelacion. Se calculan todos los desplazamientos. */
+
+struct DatosMicro{
+	float *iq;
+	float *modulo;
+	float *vector;
+	float *resultado;
+	int largo;
+	struct AlmacenPulsos almacen;
+	struct Gate *gates;
+	char captura[32];
+	char resultados[32];
+	uint64_t tamano_captura;
+};
+/*!< Datos sinteticos compartidos por los microbenchmarks. */
+
+struct Micro{
+	const char *nombre;
+	void (*kernel)(struct DatosMicro *datos);
+	int largo;
+	double flops;
+	double bytes;
+	double segundos;
+};
+/*!< Microbenchmark: kernel a medir, largo del vector (o 0), y FLOPs y bytes
+de cada llamada. Los bytes son el trafico minimo con memoria: cada dato de
+entrada leido y cada resultado escrito una vez. */
+
+/**
+* @brief Mide el tiempo de una llamada a un kernel.
+*
+* Repite el kernel, duplicando el numero de llamadas, hasta que la medicion
+* dure al menos TIEMPO_MINIMO_MICRO, y se queda con la mejor de varias
+* mediciones.
+*
+* @param kernel Kernel a medir.
+* @param datos Datos del kernel.
+* @param mediciones Numero de mediciones.
+* @return Segundos por llamada.
+*/
+static double
+medir_kernel(void (*kernel)(struct DatosMicro *), struct DatosMicro *datos, int mediciones){
+	double mejor = 0;
+	for (int m = 0; m < mediciones; ++m)
+	{
+		long llamadas = 1;
+		double transcurrido;
+		for(;;){
+			double inicio = omp_get_wtime();
+			for (long i = 0; i < llamadas; ++i)
+			{
+				kernel(datos);
+			}
+			transcurrido = omp_get_wtime() - inicio;
+			if(transcurrido >= TIEMPO_MINIMO_MICRO){
+				break;
+			}
+			llamadas *= 2;
+		}
+		if(m == 0 || transcurrido / llamadas < mejor){
+			mejor = transcurrido / llamadas;
+		}
+	}
+	return mejor;
+}
+
+#ifdef MICRO_X86
+
+/**
+* @brief Pico de calculo con FMAs de AVX-512: 8 cadenas independientes de 16 floats.
+*
+* @return Un valor derivado de los acumuladores, para que el bucle no se elimine.
+*/
+__attribute__((target("avx512f")))
+static float
+pico_avx512(void){
+	__m512 m = _mm512_set1_ps(0.999999f), s = _mm512_set1_ps(1e-7f);
+	__m512 a0 = _mm512_set1_ps(0), a1 = _mm512_set1_ps(1), a2 = _mm512_set1_ps(2), a3 = _mm512_set1_ps(3);
+	__m512 a4 = _mm512_set1_ps(4), a5 = _mm512_set1_ps(5), a6 = _mm512_set1_ps(6), a7 = _mm512_set1_ps(7);
+	for (long i = 0; i < ITERACIONES_PICO; ++i)
+	{
+		a0 = _mm512_fmadd_ps(a0, m, s); a1 = _mm512_fmadd_ps(a1, m, s);
+		a2 = _mm512_fmadd_ps(a2, m, s); a3 = _mm512_fmadd_ps(a3, m, s);
+		a4 = _mm512_fmadd_ps(a4, m, s); a5 = _mm512_fmadd_ps(a5, m, s);
+		a6 = _mm512_fmadd_ps(a6, m, s); a7 = _mm512_fmadd_ps(a7, m, s);
+	}
+	a0 = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(a0, a1), _mm512_add_ps(a2, a3)),
+		_mm512_add_ps(_mm512_add_ps(a4, a5), _mm512_add_ps(a6, a7)));
+	return _mm512_reduce_add_ps(a0);
+}
+
+/**
+* @brief Pico de calculo con FMAs de AVX2: 8 cadenas independientes de 8 floats.
+*
+* @return Un valor derivado de los acumuladores, para que el bucle no se elimine.
+*/
+__attribute__((target("avx2,fma")))
+static float
+pico_avx2(void){
+	__m256 m = _mm256_set1_ps(0.999999f), s = _mm256_set1_ps(1e-7f);
+	__m256 a0 = _mm256_set1_ps(0), a1 = _mm256_set1_ps(1), a2 = _mm256_set1_ps(2), a3 = _mm256_set1_ps(3);
+	__m256 a4 = _mm256_set1_ps(4), a5 = _mm256_set1_ps(5), a6 = _mm256_set1_ps(6), a7 = _mm256_set1_ps(7);
+	for (long i = 0; i < ITERACIONES_PICO; ++i)
+	{
+		a0 = _mm256_fmadd_ps(a0, m, s); a1 = _mm256_fmadd_ps(a1, m, s);
+		a2 = _mm256_fmadd_ps(a2, m, s); a3 = _mm256_fmadd_ps(a3, m, s);
+		a4 = _mm256_fmadd_ps(a4, m, s); a5 = _mm256_fmadd_ps(a5, m, s);
+		a6 = _mm256_fmadd_ps(a6, m, s); a7 = _mm256_fmadd_ps(a7, m, s);
+	}
+	float suma[8];
+	a0 = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(a0, a1), _mm256_add_ps(a2, a3)),
+		_mm256_add_ps(_mm256_add_ps(a4, a5), _mm256_add_ps(a6, a7)));
+	_mm256_storeu_ps(suma, a0);
+	return suma[0] + suma[7];
+}
+
+/**
+* @brief Pico de calculo con SSE, sin FMA: 8 cadenas independientes de producto y suma de 4 floats.
+*
+* @return Un valor derivado de los acumuladores, para que el bucle no se elimine.
+*/
+__attribute__((target("sse2")))
+static float
+pico_sse(void){
+	__m128 m = _mm_set1_ps(0.999999f), s = _mm_set1_ps(1e-7f);
+	__m128 a0 = _mm_set1_ps(0), a1 = _mm_set1_ps(1), a2 = _mm_set1_ps(2), a3 = _mm_set1_ps(3);
+	__m128 a4 = _mm_set1_ps(4), a5 = _mm_set1_ps(5), a6 = _mm_set1_ps(6), a7 = _mm_set1_ps(7);
+	for (long i = 0; i < ITERACIONES_PICO; ++i)
+	{
+		a0 = _mm_add_ps(_mm_mul_ps(a0, m), s); a1 = _mm_add_ps(_mm_mul_ps(a1, m), s);
+		a2 = _mm_add_ps(_mm_mul_ps(a2, m), s); a3 = _mm_add_ps(_mm_mul_ps(a3, m), s);
+		a4 = _mm_add_ps(_mm_mul_ps(a4, m), s); a5 = _mm_add_ps(_mm_mul_ps(a5, m), s);
+		a6 = _mm_add_ps(_mm_mul_ps(a6, m), s); a7 = _mm_add_ps(_mm_mul_ps(a7, m), s);
+	}
+	float suma[4];
+	a0 = _mm_add_ps(_mm_add_ps(_mm_add_ps(a0, a1), _mm_add_ps(a2, a3)),
+		_mm_add_ps(_mm_add_ps(a4, a5), _mm_add_ps(a6, a7)));
+	_mm_storeu_ps(suma, a0);
+	return suma[0] + suma[3];
+}
+
+#endif
+
+/**
+* @brief Pico de calculo escalar: 8 cadenas independientes de producto y suma.
+*
+* @return Un valor derivado de los acumuladores, para que el bucle no se elimine.
+*/
+static float
+pico_escalar(void){
+	volatile float entrada = 0.999999f;
+	float m = entrada, s = 1e-7f;
+	float a0 = 0, a1 = 1, a2 = 2, a3 = 3, a4 = 4, a5 = 5, a6 = 6, a7 = 7;
+	for (long i = 0; i < ITERACIONES_PICO; ++i)
+	{
+		a0 = a0*m + s; a1 = a1*m + s; a2 = a2*m + s; a3 = a3*m + s;
+		a4 = a4*m + s; a5 = a5*m + s; a6 = a6*m + s; a7 = a7*m + s;
+	}
+	return a0 + a1 + a2 + a3 + a4 + a5 + a6 + a7;
+}
+
+/**
+* @brief Mide el pico de calculo de un nucleo con los kernels elegidos.
+*
+* @param kernels[] Nombre de los kernels SIMD en uso ("avx512", "avx2", "sse" o "escalar").
+* @return FLOPs por segundo.
+*/
+static double
+medir_pico_flops(const char kernels[]){
+	float (*pico)(void) = pico_escalar;
+	int floats = 1;
+#ifdef MICRO_X86
+	if(strcmp(kernels, "avx512") == 0){
+		pico = pico_avx512;
+		floats = 16;
+	}
+	else if(strcmp(kernels, "avx2") == 0){
+		pico = pico_avx2;
+		floats = 8;
+	}
+	else if(strcmp(kernels, "sse") == 0){
+		pico = pico_sse;
+		floats = 4;
+	}
+#endif
+	double mejor = 0;
+	volatile float sumidero;
+	for (int m = 0; m < MEDICIONES_MICRO; ++m)
+	{
+		double inicio = omp_get_wtime();
+		sumidero = pico();
+		double transcurrido = omp_get_wtime() - inicio;
+		if(m == 0 || transcurrido < mejor){
+			mejor = transcurrido;
+		}
+	}
+	(void)sumidero;
+	return 2.0 * 8 * floats * ITERACIONES_PICO / mejor;
+}
+
+/**
+* @brief Mide el ancho de banda a memoria de un nucleo con la triada de STREAM.
+*
+* Se cuentan 12 bytes por elemento (dos lecturas y una escritura), como en
+* STREAM, sin la lectura extra que hace la cache antes de escribir.
+*
+* @return Bytes por segundo.
+*/
+static double
+medir_pico_bytes(void){
+	float *a = safe_malloc(sizeof(float) * ELEMENTOS_STREAM);
+	float *b = safe_malloc(sizeof(float) * ELEMENTOS_STREAM);
+	float *c = safe_malloc(sizeof(float) * ELEMENTOS_STREAM);
+	double mejor = 0;
+	for (long i = 0; i < ELEMENTOS_STREAM; ++i)
+	{
+		a[i] = 0;
+		b[i] = 1;
+		c[i] = 2;
+	}
+	for (int m = 0; m < MEDICIONES_MICRO + 1; ++m)
+	{
+		double inicio = omp_get_wtime();
+		for (long i = 0; i < ELEMENTOS_STREAM; ++i)
+		{
+			a[i] = b[i] + 3.0f * c[i];
+		}
+		double transcurrido = omp_get_wtime() - inicio;
+		if(m == 1 || (m > 1 && transcurrido < mejor)){
+			mejor = transcurrido;
+		}
+	}
+	volatile float sumidero = a[ELEMENTOS_STREAM / 2];
+	(void)sumidero;
+	free(a);
+	free(b);
+	free(c);
+	return 12.0 * ELEMENTOS_STREAM / mejor;
+}
+
+/**
+* @brief Modulo de cada muestra con valor_absoluto(), una por llamada.
+*/
+static void
+micro_valor_absoluto(struct DatosMicro *datos){
+	for (int i = 0; i < MUESTRAS_MODULO; ++i)
+	{
+		datos->modulo[i] = valor_absoluto(datos->iq[2*i], datos->iq[2*i+1]);
+	}
+}
+
+/**
+* @brief Modulo de todas las muestras con el kernel por lotes.
+*/
+static void
+micro_modulos_iq(struct DatosMicro *datos){
+	modulos_iq(datos->iq, MUESTRAS_MODULO, datos->modulo);
+}
+
+/**
+* @brief Modulos y promedios por gate de todas las tablas de la captura.
+*/
+static void
+micro_promedio(struct DatosMicro *datos){
+	promedio_y_valor_absoluto(&datos->almacen, datos->gates);
+}
+
+/**
+* @brief Lectura de la captura sintetica a un almacen, con leer_archivo().
+*
+* La captura esta en la cache de paginas, por lo que se mide la copia de las
+* tablas y el costo de fread, no el disco.
+*/
+static void
+micro_lectura(struct DatosMicro *datos){
+	struct AlmacenPulsos almacen;
+	if(leer_archivo(datos->captura, &almacen, PULSOS_MICRO, datos->tamano_captura) == 0){
+		liberar_almacen(&almacen);
+	}
+}
+
+/**
+* @brief Autocorrelacion directa de un vector, con todos los desplazamientos.
+*/
+static void
+micro_autocorrelacion(struct DatosMicro *datos){
+	autocorrelacion(datos->vector, datos->largo, datos->largo, datos->resultado);
+}
+
+/**
+* @brief Autocorrelacion con el kernel vectorizado, con todos los desplazamientos.
+*/
+static void
+micro_autocorrelacion_simd(struct DatosMicro *datos){
+	autocorrelacion_simd(datos->vector, datos->largo, datos->largo, datos->resultado);
+}
+
+/**
+* @brief Escritura de los resultados de todos los gates con guardar_archivo(), en formato v1.
+*/
+static void
+micro_escritura(struct DatosMicro *datos){
+	struct Formato formato;
+	preparar_formato(&formato, FORMATO_V1, PULSOS_MICRO, PULSOS_MICRO);
+	guardar_archivo(datos->gates, datos->resultados, &formato);
+}
+
+/**
+* @brief Genera los datos sinteticos: muestras I/Q, una captura en un archivo
+* temporal y en un almacen, y la matriz de gates.
+*
+* @param datos Datos a generar.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+static int
+crear_datos_micro(struct DatosMicro *datos){
+	int maximo = largos_autocorr[sizeof(largos_autocorr)/sizeof(largos_autocorr[0]) - 1];
+	size_t floats_pulso = 4 * MUESTRAS_MICRO;
+	uint16_t valid_samples = MUESTRAS_MICRO;
+
+	srand(1);
+	datos->iq = safe_malloc(sizeof(float) * 2 * MUESTRAS_MODULO);
+	datos->modulo = safe_malloc(sizeof(float) * MUESTRAS_MODULO);
+	datos->vector = safe_malloc(sizeof(float) * maximo);
+	datos->resultado = safe_malloc(sizeof(float) * maximo);
+	for (int i = 0; i < 2 * MUESTRAS_MODULO; ++i)
+	{
+		datos->iq[i] = (float)rand() / RAND_MAX - 0.5f;
+	}
+	for (int i = 0; i < maximo; ++i)
+	{
+		datos->vector[i] = (float)rand() / RAND_MAX;
+	}
+
+	crear_almacen(&datos->almacen, PULSOS_MICRO, PULSOS_MICRO * floats_pulso);
+	strcpy(datos->captura, "/tmp/micro_pulsos_XXXXXX");
+	strcpy(datos->resultados, "/tmp/micro_out_XXXXXX");
+	int fd_captura = mkstemp(datos->captura);
+	int fd_resultados = mkstemp(datos->resultados);
+	if(fd_captura < 0 || fd_resultados < 0){
+		printf(BOLDRED"Error creando archivos temporales\n"RESET);
+		return 1;
+	}
+	close(fd_resultados);
+	FILE *f = fdopen(fd_captura, "wb");
+	int error = f == NULL;
+	for (int p = 0; p < PULSOS_MICRO && !error; ++p)
+	{
+		ubicar_pulso(&datos->almacen, p, MUESTRAS_MICRO);
+		float *tabla = (float *)tabla_pulso(&datos->almacen, p);
+		for (size_t i = 0; i < floats_pulso; ++i)
+		{
+			tabla[i] = (float)rand() / RAND_MAX - 0.5f;
+		}
+		error = fwrite(&valid_samples, sizeof(uint16_t), 1, f) != 1
+			|| fwrite(tabla, sizeof(float), floats_pulso, f) != floats_pulso;
+	}
+	if(f == NULL || fclose(f) != 0 || error){
+		printf(BOLDRED"Error escribiendo captura sintetica\n"RESET);
+		return 1;
+	}
+	datos->tamano_captura = PULSOS_MICRO * (sizeof(uint16_t) + sizeof(float) * floats_pulso);
+
+	datos->gates = safe_malloc(sizeof(struct Gate) * radar.num_gates);
+	initialize_gates(datos->gates, PULSOS_MICRO);
+	promedio_y_valor_absoluto(&datos->almacen, datos->gates);
+	calcular_autocorrelacion(datos->gates, PULSOS_MICRO, PULSOS_MICRO, NULL);
+	return 0;
+}
+
+/**
+* @brief Libera los datos sinteticos y borra los archivos temporales.
+*
+* @param datos Datos generados con crear_datos_micro().
+*/
+static void
+liberar_datos_micro(struct DatosMicro *datos){
+	free_gates(datos->gates, PULSOS_MICRO);
+	free(datos->gates);
+	liberar_almacen(&datos->almacen);
+	unlink(datos->captura);
+	unlink(datos->resultados);
+	free(datos->iq);
+	free(datos->modulo);
+	free(datos->vector);
+	free(datos->resultado);
+}
+
+/**
+* @brief Arma la lista de microbenchmarks, con los FLOPs y bytes de cada llamada.
+*
+* El modulo de una muestra I/Q cuenta 4 FLOPs (dos productos, una suma y la
+* raiz); el promedio por gate agrega una suma por modulo. La autocorrelacion
+* directa con L = N desplazamientos hace N(N+1)/2 productos y sumas.
+*
+* @param micros[] Lista a completar.
+* @return Numero de microbenchmarks.
+*/
+static int
+armar_micros(struct Micro micros[]){
+	int n = 0;
+	double muestras_captura = (double)PULSOS_MICRO * MUESTRAS_MICRO;
+	double bytes_tablas = muestras_captura * 4 * sizeof(float);
+	double bytes_resultados = sizeof(uint16_t) + (double)radar.num_gates * (sizeof(uint16_t) + 2 * PULSOS_MICRO * sizeof(float));
+
+	micros[n++] = (struct Micro){"valor_absoluto", micro_valor_absoluto, MUESTRAS_MODULO,
+		4.0 * MUESTRAS_MODULO, 12.0 * MUESTRAS_MODULO, 0};
+	micros[n++] = (struct Micro){"modulos_iq", micro_modulos_iq, MUESTRAS_MODULO,
+		4.0 * MUESTRAS_MODULO, 12.0 * MUESTRAS_MODULO, 0};
+	micros[n++] = (struct Micro){"promedio_y_valor_absoluto", micro_promedio, PULSOS_MICRO,
+		10.0 * muestras_captura, bytes_tablas + 2.0 * sizeof(float) * PULSOS_MICRO * radar.num_gates, 0};
+	micros[n++] = (struct Micro){"leer_archivo", micro_lectura, PULSOS_MICRO,
+		0, 2 * bytes_tablas, 0};
+	for (size_t i = 0; i < sizeof(largos_autocorr)/sizeof(largos_autocorr[0]); ++i)
+	{
+		double largo = largos_autocorr[i];
+		micros[n++] = (struct Micro){"autocorrelacion", micro_autocorrelacion, largos_autocorr[i],
+			largo * (largo + 1), 8 * largo, 0};
+		micros[n++] = (struct Micro){"autocorrelacion_simd", micro_autocorrelacion_simd, largos_autocorr[i],
+			largo * (largo + 1), 8 * largo, 0};
+	}
+	micros[n++] = (struct Micro){"guardar_archivo", micro_escritura, PULSOS_MICRO,
+		0, bytes_resultados, 0};
+	return n;
+}
+
+/**
+* @brief Guarda los techos y el resultado de cada microbenchmark en JSON.
+*
+* @param filename[] Nombre del archivo.
+* @param kernels[] Nombre de los kernels SIMD en uso.
+* @param pico_flops Pico de calculo, en FLOPs por segundo.
+* @param pico_bytes Ancho de banda a memoria, en bytes por segundo.
+* @param micros[] Microbenchmarks medidos.
+* @param n Numero de microbenchmarks.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+static int
+guardar_json_micro(char filename[], const char kernels[], double pico_flops, double pico_bytes, const struct Micro micros[], int n){
+	FILE *f = fopen(filename, "w");
+	if(!f){
+		printf(BOLDRED"Error abriendo archivo para escritura\n"RESET);
+		return 1;
+	}
+	fprintf(f, "{\n  \"kernels\": \"%s\",\n", kernels);
+	fprintf(f, "  \"pico_gflops\": %.3f,\n  \"pico_gbs\": %.3f,\n  \"punto_cruce\": %.3f,\n",
+		pico_flops / 1e9, pico_bytes / 1e9, pico_flops / pico_bytes);
+	fprintf(f, "  \"micros\": [\n");
+	for (int i = 0; i < n; ++i)
+	{
+		double intensidad = micros[i].bytes > 0 ? micros[i].flops / micros[i].bytes : 0;
+		double techo = intensidad * pico_bytes < pico_flops ? intensidad * pico_bytes : pico_flops;
+		fprintf(f, "    {\"nombre\": \"%s\", \"largo\": %d, \"segundos\": %.9f, \"gflops\": %.3f, \"gbs\": %.3f, "
+			"\"intensidad\": %.4f, \"fraccion_pico_flops\": %.4f, \"fraccion_pico_bw\": %.4f, "
+			"\"fraccion_techo\": %.4f, \"limite\": \"%s\"}%s\n",
+			micros[i].nombre, micros[i].largo, micros[i].segundos,
+			micros[i].flops / micros[i].segundos / 1e9, micros[i].bytes / micros[i].segundos / 1e9,
+			intensidad, micros[i].flops / micros[i].segundos / pico_flops, micros[i].bytes / micros[i].segundos / pico_bytes,
+			techo > 0 ? micros[i].flops / micros[i].segundos / techo : micros[i].bytes / micros[i].segundos / pico_bytes,
+			intensidad < pico_flops / pico_bytes ? "memoria" : "calculo",
+			i < n - 1 ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+
+	int error = ferror(f);
+	if(fclose(f) != 0){
+		error = 1;
+	}
+	return error;
+}
+
+ /**
+* @brief Función main de los microbenchmarks.
+*
+* Acepta parametros opcionales:
+* -n <mediciones> Mediciones de cada kernel (3 por defecto); se informa la mejor.
+* -j <archivo> Archivo JSON de resultados ("micro.json" por defecto).
+* -k <kernels> Kernels vectoriales a medir, como en build/radar.
+* -g <gates> Numero de gates de la matriz sintetica.
+*/
+int
+main(int argc, char *argv[])
+{
+	char *json = "micro.json";
+	char *preferidos = NULL;
+	int mediciones = MEDICIONES_MICRO;
+	struct DatosMicro datos;
+	struct Micro micros[MAX_KERNELS_MICRO];
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if(strcmp(argv[i],"-n") == 0 && i+1 < argc && atoi(argv[i+1]) > 0){
+			mediciones = atoi(argv[++i]);
+		}
+		else if(strcmp(argv[i],"-j") == 0 && i+1 < argc){
+			json = argv[++i];
+		}
+		else if(strcmp(argv[i],"-k") == 0 && i+1 < argc){
+			preferidos = argv[++i];
+		}
+		else if(strcmp(argv[i],"-g") == 0 && i+1 < argc && atoi(argv[i+1]) > 0 && atoi(argv[i+1]) <= MAX_GATES){
+			radar.num_gates = atoi(argv[++i]);
+		}
+		else{
+			printf("No se reconoce el comando "BOLDRED"%s\n"RESET, argv[i]);
+		}
+	}
+
+	omp_set_num_threads(1);
+	const char *kernels = inicializar_simd(preferidos);
+	printf("Midiendo techos de un nucleo (kernels "BOLDGREEN"%s"RESET")...\n", kernels);
+	double pico_flops = medir_pico_flops(kernels);
+	double pico_bytes = medir_pico_bytes();
+	printf("Pico de calculo: "BOLDGREEN"%.2f"RESET" GFLOP/s, ancho de banda: "BOLDGREEN"%.2f"RESET" GB/s, punto de cruce: %.2f FLOP/byte\n",
+		pico_flops / 1e9, pico_bytes / 1e9, pico_flops / pico_bytes);
+
+	silenciar_salida(1);
+	int error = crear_datos_micro(&datos);
+	silenciar_salida(0);
+	if(error != 0){
+		printf(BOLDRED"Error generando datos sinteticos\n"RESET);
+		exit(EXIT_FAILURE);
+	}
+
+	int n = armar_micros(micros);
+	printf("%-26s %7s %10s %9s %9s %8s %8s  %s\n", "kernel", "largo", "segundos", "GFLOP/s", "GB/s", "FLOP/B", "%techo", "limite");
+	for (int i = 0; i < n; ++i)
+	{
+		if(micros[i].kernel == micro_autocorrelacion || micros[i].kernel == micro_autocorrelacion_simd){
+			datos.largo = micros[i].largo;
+		}
+		silenciar_salida(1);
+		micros[i].segundos = medir_kernel(micros[i].kernel, &datos, mediciones);
+		silenciar_salida(0);
+
+		double gflops = micros[i].flops / micros[i].segundos / 1e9;
+		double gbs = micros[i].bytes / micros[i].segundos / 1e9;
+		double intensidad = micros[i].bytes > 0 ? micros[i].flops / micros[i].bytes : 0;
+		double techo = intensidad * pico_bytes < pico_flops ? intensidad * pico_bytes : pico_flops;
+		double fraccion = techo > 0 ? micros[i].flops / micros[i].segundos / techo : micros[i].bytes / micros[i].segundos / pico_bytes;
+		printf("%-26s %7d %10.6f %9.2f %9.2f %8.3f %7.1f%%  %s\n", micros[i].nombre, micros[i].largo,
+			micros[i].segundos, gflops, gbs, intensidad, 100 * fraccion,
+			intensidad < pico_flops / pico_bytes ? "memoria" : "calculo");
+	}
+	liberar_datos_micro(&datos);
+
+	if(guardar_json_micro(json, kernels, pico_flops, pico_bytes, micros, n) != 0){
+		printf(BOLDRED"Error guardando resultados de los microbenchmarks\n"RESET);
+		exit(EXIT_FAILURE);
+	}
+	printf("Resultados guardados en "BOLDGREEN"'%s'\n"RESET, json);
+	return 0;
+}
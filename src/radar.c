@@ -0,0 +1,8 @@
+/** @file radar.c
+ *  @brief Configuracion del radar compartida por ambos programas.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/radar.h"
+
+struct Radar radar = {NUM_GATES_DEFECTO, MAX_DATOS_LECTURA_DEFECTO};
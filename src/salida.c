@@ -0,0 +1,169 @@
+/** @file salida.c
+ *  @brief Escritura posicional del archivo de resultados.
+ *
+ *  Produce el mismo archivo que guardar_archivo(), pero gate por gate y en
+ *  cualquier orden: cada gate se escribe en su offset con una unica llamada
+ *  a pwritev, que es segura desde varios hilos a la vez.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/radar.h"
+#include "../include/salida.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+/**
+* @brief Escribe todos los bytes de un vector de buffers en un offset.
+*
+* pwritev puede escribir menos de lo pedido; en ese caso se avanza sobre el
+* vector y se reintenta con el resto.
+*
+* @param fd Archivo abierto para escritura.
+* @param iov Buffers a escribir. Se modifica.
+* @param cantidad Numero de buffers.
+* @param offset Offset del primer byte.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+static int
+escribir_vector(int fd, struct iovec iov[], int cantidad, off_t offset){
+	while(cantidad > 0){
+		ssize_t r = pwritev(fd, iov, cantidad, offset);
+		if(r < 0 && errno == EINTR){
+			continue;
+		}
+		if(r <= 0){
+			return 1;
+		}
+		offset += r;
+		while(cantidad > 0 && (size_t)r >= iov[0].iov_len){
+			r -= iov[0].iov_len;
+			iov++;
+			cantidad--;
+		}
+		if(cantidad > 0){
+			iov[0].iov_base = (char *)iov[0].iov_base + r;
+			iov[0].iov_len -= r;
+		}
+	}
+	return 0;
+}
+
+/**
+* @brief Crea el archivo de resultados con su tamaño final y escribe el encabezado.
+*
+* En el formato versionado, la tabla de offsets se escribe completa desde el
+* inicio, ya que todos los gates ocupan lo mismo.
+*
+* @param salida Salida a inicializar.
+* @param filename[] Nombre del archivo de resultados.
+* @param formato Descripcion del archivo, con una codificacion de tamaño fijo.
+* @return 1 si hubo un error, 0 caso contrario.
+*/
+int
+abrir_salida(struct Salida *salida, char filename[], const struct Formato *formato){
+	salida->formato = *formato;
+	salida->bytes_gate = bytes_gate_formato(formato);
+	atomic_init(&salida->error, 0);
+	if(salida->bytes_gate == 0){
+		printf(BOLDRED"La codificacion elegida no admite escritura posicional\n"RESET);
+		return 1;
+	}
+	salida->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(salida->fd < 0){
+		printf(BOLDRED"Error abriendo archivo para escritura\n"RESET);
+		return 1;
+	}
+
+	int error;
+	if(formato->codificacion == FORMATO_V1){
+		uint16_t nro_lags = formato->num_lags;
+		salida->inicio_gates = sizeof(uint16_t);
+		error = pwrite(salida->fd, &nro_lags, sizeof(uint16_t), 0) != sizeof(uint16_t);
+	}
+	else{
+		struct EncabezadoFormato encabezado;
+		uint64_t *offsets = safe_malloc(sizeof(uint64_t) * (radar.num_gates + 1));
+		armar_encabezado_formato(formato, &encabezado);
+		salida->inicio_gates = bytes_encabezado_formato();
+		for (int i = 0; i <= radar.num_gates; ++i)
+		{
+			offsets[i] = salida->inicio_gates + (uint64_t)i * salida->bytes_gate;
+		}
+		struct iovec iov[2] = {
+			{&encabezado, sizeof(encabezado)},
+			{offsets, sizeof(uint64_t) * (radar.num_gates + 1)}
+		};
+		error = escribir_vector(salida->fd, iov, 2, 0);
+		free(offsets);
+	}
+
+	if(error || ftruncate(salida->fd, salida->inicio_gates + (off_t)radar.num_gates * salida->bytes_gate) != 0){
+		printf(BOLDRED"Error escribiendo archivo\n"RESET);
+		close(salida->fd);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+* @brief Escribe el bloque de un gate en su lugar del archivo de resultados.
+*
+* Puede llamarse desde varios hilos a la vez, cada uno con gates distintos.
+* Un error se registra en salida->error y se informa en cerrar_salida().
+*
+* @param salida Salida abierta con abrir_salida().
+* @param gate Gate con su autocorrelacion ya calculada.
+* @param indice Numero del gate.
+*/
+void
+escribir_gate_salida(struct Salida *salida, const struct Gate *gate, int indice){
+	off_t offset = salida->inicio_gates + (off_t)indice * salida->bytes_gate;
+	size_t bytes_vector = sizeof(float) * salida->formato.num_lags;
+	uint16_t nro_gate = indice;
+	int error;
+
+	if(salida->formato.codificacion == FORMATO_V1){
+		struct iovec iov[3] = {
+			{&nro_gate, sizeof(uint16_t)},
+			{gate->vector_autocorr_v, bytes_vector},
+			{gate->vector_autocorr_h, bytes_vector}
+		};
+		error = escribir_vector(salida->fd, iov, 3, offset);
+	}
+	else if(salida->formato.codificacion == FORMATO_F32){
+		struct iovec iov[2] = {
+			{gate->vector_autocorr_v, bytes_vector},
+			{gate->vector_autocorr_h, bytes_vector}
+		};
+		error = escribir_vector(salida->fd, iov, 2, offset);
+	}
+	else{
+		unsigned char *buffer = safe_malloc(salida->bytes_gate);
+		struct iovec iov[1] = {
+			{buffer, codificar_gate(&salida->formato, gate, buffer)}
+		};
+		error = escribir_vector(salida->fd, iov, 1, offset);
+		free(buffer);
+	}
+
+	if(error){
+		atomic_store(&salida->error, 1);
+	}
+}
+
+/**
+* @brief Cierra el archivo de resultados.
+*
+* @param salida Salida abierta con abrir_salida().
+* @return 1 si fallo la escritura de algun gate o el cierre, 0 caso contrario.
+*/
+int
+cerrar_salida(struct Salida *salida){
+	int error = atomic_load(&salida->error);
+	if(close(salida->fd) != 0){
+		error = 1;
+	}
+	return error;
+}
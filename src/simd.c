@@ -0,0 +1,479 @@
+/** @file simd.c
+ *  @brief Kernels vectorizados con seleccion segun la CPU.
+ *
+ *  El kernel de autocorrelacion calcula LAGS_POR_PASADA desplazamientos por
+ *  cada pasada sobre el vector. Los productos se acumulan en varios registros
+ *  vectoriales independientes, lo que elimina la dependencia entre iteraciones
+ *  de la suma escalar original. Al cambiar el orden de las sumas, el resultado
+ *  no es identico bit a bit al de autocorrelacion().
+ *
+ *  El kernel de modulo, en cambio, reproduce exactamente a valor_absoluto():
+ *  eleva al cuadrado y suma en doble precision empaquetada, y redondea a float
+ *  solo despues de la raiz.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/radar.h"
+#include "../include/simd.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86
+#endif
+
+typedef void (*KernelAutocorr)(const float vector[], int len, int num_lags, float resultado[]);
+/*!< Firma comun de los kernels de autocorrelacion. */
+typedef void (*KernelModulo)(const void *iq, int n, float modulo[]);
+/*!< Firma comun de los kernels de modulo sobre pares I/Q intercalados. */
+
+/**
+* @brief Lee un float que puede no estar alineado a 4 bytes.
+*
+* @param p Inicio del arreglo de floats.
+* @param indice Posicion del float a leer.
+* @return El valor leido.
+*/
+static inline float
+cargar_float(const void *p, int indice){
+	float valor;
+	memcpy(&valor, (const char *)p + (size_t)indice*sizeof(float), sizeof(float));
+	return valor;
+}
+
+/**
+* @brief Kernel escalar de modulo, a partir de la muestra n0.
+*
+* Calcula igual que valor_absoluto(): pow(u,2) de un float es exacto en doble
+* precision, por lo que equivale a u*u en double.
+*
+* @param iq Pares I/Q intercalados.
+* @param n0 Primera muestra a calcular.
+* @param n Numero total de muestras.
+* @param modulo[] Modulo de cada muestra.
+*/
+static void
+completar_modulos(const void *iq, int n0, int n, float modulo[]){
+	for (int k = n0; k < n; ++k)
+	{
+		double u = cargar_float(iq, 2*k), v = cargar_float(iq, 2*k+1);
+		modulo[k] = sqrt(u*u + v*v);
+	}
+}
+
+/**
+* @brief Kernel escalar de modulo.
+*
+* @param iq Pares I/Q intercalados.
+* @param n Numero de muestras.
+* @param modulo[] Modulo de cada muestra.
+*/
+static void
+modulos_escalar(const void *iq, int n, float modulo[]){
+	completar_modulos(iq, 0, n, modulo);
+}
+
+/**
+* @brief Termina en escalar los desplazamientos de una pasada.
+*
+* Los kernels vectoriales recorren solo el rango de j valido para los
+* LAGS_POR_PASADA desplazamientos y de a bloques completos; este helper suma
+* los productos restantes de cada desplazamiento y normaliza.
+*
+* @param vector[] Vector a calcular la autocorrelacion.
+* @param len Longitud del vector.
+* @param lag Primer desplazamiento de la pasada.
+* @param j Primer indice no procesado por el kernel vectorial.
+* @param suma[] Sumas parciales de cada desplazamiento de la pasada.
+* @param resultado[] Resultado del calculo.
+*/
+static void
+completar_pasada(const float vector[], int len, int lag, int j, float suma[], float resultado[]){
+	for (int q = 0; q < LAGS_POR_PASADA; ++q)
+	{
+		for (int k = j; k < len-lag-q; ++k)
+		{
+			suma[q] += vector[k] * vector[k+lag+q];
+		}
+		resultado[lag+q] = suma[q]/len;
+	}
+}
+
+/**
+* @brief Calcula en escalar los desplazamientos que no completan una pasada.
+*
+* @param vector[] Vector a calcular la autocorrelacion.
+* @param len Longitud del vector.
+* @param desde Primer desplazamiento a calcular.
+* @param num_lags Numero total de desplazamientos a calcular.
+* @param resultado[] Resultado del calculo.
+*/
+static void
+completar_lags(const float vector[], int len, int desde, int num_lags, float resultado[]){
+	for (int i = desde; i < num_lags; ++i)
+	{
+		float suma = 0;
+		for (int j = 0; j < len-i; ++j)
+		{
+			suma += vector[j] * vector[j+i];
+		}
+		resultado[i] = suma/len;
+	}
+}
+
+/**
+* @brief Kernel escalar, con LAGS_POR_PASADA acumuladores por pasada.
+*
+* @param vector[] Vector a calcular la autocorrelacion.
+* @param len Longitud del vector.
+* @param num_lags Numero de desplazamientos a calcular, de 0 a num_lags-1. Como maximo len.
+* @param resultado[] Resultado del calculo.
+*/
+static void
+autocorrelacion_escalar(const float vector[], int len, int num_lags, float resultado[]){
+	int i = 0;
+	for (; i + LAGS_POR_PASADA <= num_lags; i += LAGS_POR_PASADA)
+	{
+		float suma[LAGS_POR_PASADA] = {0};
+		int fin = len - (i + LAGS_POR_PASADA - 1);
+		for (int j = 0; j < fin; ++j)
+		{
+			for (int q = 0; q < LAGS_POR_PASADA; ++q)
+			{
+				suma[q] += vector[j] * vector[j+i+q];
+			}
+		}
+		completar_pasada(vector, len, i, fin, suma, resultado);
+	}
+	completar_lags(vector, len, i, num_lags, resultado);
+}
+
+#ifdef SIMD_X86
+
+/**
+* @brief Kernel SSE, 4 floats por registro.
+*
+* @param vector[] Vector a calcular la autocorrelacion.
+* @param len Longitud del vector.
+* @param num_lags Numero de desplazamientos a calcular, de 0 a num_lags-1. Como maximo len.
+* @param resultado[] Resultado del calculo.
+*/
+__attribute__((target("sse2")))
+static void
+autocorrelacion_sse(const float vector[], int len, int num_lags, float resultado[]){
+	int i = 0;
+	for (; i + LAGS_POR_PASADA <= num_lags; i += LAGS_POR_PASADA)
+	{
+		__m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+		__m128 acc2 = _mm_setzero_ps(), acc3 = _mm_setzero_ps();
+		int fin = len - (i + LAGS_POR_PASADA - 1);
+		int j = 0;
+		for (; j + 4 <= fin; j += 4)
+		{
+			__m128 x = _mm_loadu_ps(&vector[j]);
+			acc0 = _mm_add_ps(acc0, _mm_mul_ps(x, _mm_loadu_ps(&vector[j+i])));
+			acc1 = _mm_add_ps(acc1, _mm_mul_ps(x, _mm_loadu_ps(&vector[j+i+1])));
+			acc2 = _mm_add_ps(acc2, _mm_mul_ps(x, _mm_loadu_ps(&vector[j+i+2])));
+			acc3 = _mm_add_ps(acc3, _mm_mul_ps(x, _mm_loadu_ps(&vector[j+i+3])));
+		}
+		float parcial[4][4];
+		_mm_storeu_ps(parcial[0], acc0);
+		_mm_storeu_ps(parcial[1], acc1);
+		_mm_storeu_ps(parcial[2], acc2);
+		_mm_storeu_ps(parcial[3], acc3);
+		float suma[LAGS_POR_PASADA];
+		for (int q = 0; q < LAGS_POR_PASADA; ++q)
+		{
+			suma[q] = (parcial[q][0] + parcial[q][1]) + (parcial[q][2] + parcial[q][3]);
+		}
+		completar_pasada(vector, len, i, j, suma, resultado);
+	}
+	completar_lags(vector, len, i, num_lags, resultado);
+}
+
+/**
+* @brief Suma horizontal de un registro AVX.
+*
+* @param v Registro de 8 floats.
+* @return Suma de sus elementos.
+*/
+__attribute__((target("avx2")))
+static float
+suma_horizontal_avx(__m256 v){
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+	return _mm_cvtss_f32(s);
+}
+
+/**
+* @brief Kernel AVX2 con FMA, 8 floats por registro.
+*
+* @param vector[] Vector a calcular la autocorrelacion.
+* @param len Longitud del vector.
+* @param num_lags Numero de desplazamientos a calcular, de 0 a num_lags-1. Como maximo len.
+* @param resultado[] Resultado del calculo.
+*/
+__attribute__((target("avx2,fma")))
+static void
+autocorrelacion_avx2(const float vector[], int len, int num_lags, float resultado[]){
+	int i = 0;
+	for (; i + LAGS_POR_PASADA <= num_lags; i += LAGS_POR_PASADA)
+	{
+		__m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+		__m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+		int fin = len - (i + LAGS_POR_PASADA - 1);
+		int j = 0;
+		for (; j + 8 <= fin; j += 8)
+		{
+			__m256 x = _mm256_loadu_ps(&vector[j]);
+			acc0 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&vector[j+i]), acc0);
+			acc1 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&vector[j+i+1]), acc1);
+			acc2 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&vector[j+i+2]), acc2);
+			acc3 = _mm256_fmadd_ps(x, _mm256_loadu_ps(&vector[j+i+3]), acc3);
+		}
+		float suma[LAGS_POR_PASADA] = {
+			suma_horizontal_avx(acc0), suma_horizontal_avx(acc1),
+			suma_horizontal_avx(acc2), suma_horizontal_avx(acc3)
+		};
+		completar_pasada(vector, len, i, j, suma, resultado);
+	}
+	completar_lags(vector, len, i, num_lags, resultado);
+}
+
+/**
+* @brief Kernel AVX-512, 16 floats por registro.
+*
+* @param vector[] Vector a calcular la autocorrelacion.
+* @param len Longitud del vector.
+* @param num_lags Numero de desplazamientos a calcular, de 0 a num_lags-1. Como maximo len.
+* @param resultado[] Resultado del calculo.
+*/
+__attribute__((target("avx512f")))
+static void
+autocorrelacion_avx512(const float vector[], int len, int num_lags, float resultado[]){
+	int i = 0;
+	for (; i + LAGS_POR_PASADA <= num_lags; i += LAGS_POR_PASADA)
+	{
+		__m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+		__m512 acc2 = _mm512_setzero_ps(), acc3 = _mm512_setzero_ps();
+		int fin = len - (i + LAGS_POR_PASADA - 1);
+		int j = 0;
+		for (; j + 16 <= fin; j += 16)
+		{
+			__m512 x = _mm512_loadu_ps(&vector[j]);
+			acc0 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&vector[j+i]), acc0);
+			acc1 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&vector[j+i+1]), acc1);
+			acc2 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&vector[j+i+2]), acc2);
+			acc3 = _mm512_fmadd_ps(x, _mm512_loadu_ps(&vector[j+i+3]), acc3);
+		}
+		float suma[LAGS_POR_PASADA] = {
+			_mm512_reduce_add_ps(acc0), _mm512_reduce_add_ps(acc1),
+			_mm512_reduce_add_ps(acc2), _mm512_reduce_add_ps(acc3)
+		};
+		completar_pasada(vector, len, i, j, suma, resultado);
+	}
+	completar_lags(vector, len, i, num_lags, resultado);
+}
+
+/**
+* @brief Kernel SSE2 de modulo, 2 muestras por iteracion.
+*
+* Los pares [I,Q] se convierten a double; unpacklo/unpackhi separan los
+* cuadrados de I y de Q para sumarlos por muestra.
+*
+* @param iq Pares I/Q intercalados, sin requisito de alineacion.
+* @param n Numero de muestras.
+* @param modulo[] Modulo de cada muestra.
+*/
+__attribute__((target("sse2")))
+static void
+modulos_sse(const void *iq, int n, float modulo[]){
+	const float *datos = iq;
+	int k = 0;
+	for (; k + 2 <= n; k += 2)
+	{
+		__m128 x = _mm_loadu_ps(&datos[2*k]);
+		__m128d a = _mm_cvtps_pd(x);
+		__m128d b = _mm_cvtps_pd(_mm_movehl_ps(x, x));
+		a = _mm_mul_pd(a, a);
+		b = _mm_mul_pd(b, b);
+		__m128d suma = _mm_add_pd(_mm_unpacklo_pd(a, b), _mm_unpackhi_pd(a, b));
+		_mm_storel_pi((__m64 *)&modulo[k], _mm_cvtpd_ps(_mm_sqrt_pd(suma)));
+	}
+	completar_modulos(iq, k, n, modulo);
+}
+
+/**
+* @brief Kernel AVX2 de modulo, 4 muestras por iteracion.
+*
+* @param iq Pares I/Q intercalados, sin requisito de alineacion.
+* @param n Numero de muestras.
+* @param modulo[] Modulo de cada muestra.
+*/
+__attribute__((target("avx2")))
+static void
+modulos_avx2(const void *iq, int n, float modulo[]){
+	const float *datos = iq;
+	int k = 0;
+	for (; k + 4 <= n; k += 4)
+	{
+		__m256 x = _mm256_loadu_ps(&datos[2*k]);
+		__m256d a = _mm256_cvtps_pd(_mm256_castps256_ps128(x));
+		__m256d b = _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1));
+		a = _mm256_mul_pd(a, a);
+		b = _mm256_mul_pd(b, b);
+		__m256d suma = _mm256_add_pd(_mm256_unpacklo_pd(a, b), _mm256_unpackhi_pd(a, b));
+		//suma queda en orden [m0, m2, m1, m3]
+		suma = _mm256_permute4x64_pd(suma, _MM_SHUFFLE(3, 1, 2, 0));
+		_mm_storeu_ps(&modulo[k], _mm256_cvtpd_ps(_mm256_sqrt_pd(suma)));
+	}
+	completar_modulos(iq, k, n, modulo);
+}
+
+#endif
+
+#ifdef SIMD_X86
+
+/**
+* @brief Indica si la CPU admite los kernels AVX-512.
+*
+* @return Distinto de 0 si los admite.
+*/
+static int
+soporta_avx512(void){
+	return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2");
+}
+
+/**
+* @brief Indica si la CPU admite los kernels AVX2.
+*
+* @return Distinto de 0 si los admite.
+*/
+static int
+soporta_avx2(void){
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+/**
+* @brief Indica si la CPU admite los kernels SSE.
+*
+* @return Distinto de 0 si los admite.
+*/
+static int
+soporta_sse(void){
+	return __builtin_cpu_supports("sse2");
+}
+
+#endif
+
+/**
+* @brief Los kernels escalares funcionan en cualquier CPU.
+*
+* @return Siempre 1.
+*/
+static int
+soporta_escalar(void){
+	return 1;
+}
+
+struct KernelsSimd{
+	const char *nombre;
+	int (*soportado)(void);
+	KernelAutocorr autocorr;
+	KernelModulo modulo;
+};
+/*!< Entrada del registro de kernels: nombre para la opcion -k, extensiones que
+requiere, y sus kernels. El kernel de modulo de AVX-512 es el de AVX2. */
+
+static const struct KernelsSimd registro_simd[] = {
+#ifdef SIMD_X86
+	{"avx512", soporta_avx512, autocorrelacion_avx512, modulos_avx2},
+	{"avx2", soporta_avx2, autocorrelacion_avx2, modulos_avx2},
+	{"sse", soporta_sse, autocorrelacion_sse, modulos_sse},
+#endif
+	{"escalar", soporta_escalar, autocorrelacion_escalar, modulos_escalar},
+};
+/*!< Kernels disponibles, del mas ancho al mas angosto. */
+
+static const struct KernelsSimd *kernels = &registro_simd[sizeof(registro_simd)/sizeof(registro_simd[0]) - 1];
+/*!< Kernels elegidos por inicializar_simd(). */
+
+/**
+* @brief Detecta las extensiones de la CPU y elige los kernels a utilizar.
+*
+* Debe llamarse una vez, antes de cualquier region paralela que use los kernels.
+* Sin preferencia (o con "auto") elige los mas anchos que admite la CPU. Si se
+* pide un juego de kernels que no existe o que la CPU no admite, se avisa y se
+* elige automaticamente.
+*
+* @param preferido[] Nombre de los kernels pedidos con la opcion -k, o NULL.
+* @return Nombre de los kernels elegidos.
+*/
+const char *
+inicializar_simd(const char preferido[]){
+	int cantidad = sizeof(registro_simd)/sizeof(registro_simd[0]);
+#ifdef SIMD_X86
+	__builtin_cpu_init();
+#endif
+	if(preferido != NULL && strcmp(preferido, "auto") != 0){
+		for (int i = 0; i < cantidad; ++i)
+		{
+			if(strcmp(registro_simd[i].nombre, preferido) == 0 && registro_simd[i].soportado()){
+				kernels = &registro_simd[i];
+				return kernels->nombre;
+			}
+		}
+		printf(BOLDYELLOW"Kernels '%s' no disponibles en esta CPU, se eligen automaticamente\n"RESET, preferido);
+	}
+	for (int i = 0; i < cantidad; ++i)
+	{
+		if(registro_simd[i].soportado()){
+			kernels = &registro_simd[i];
+			break;
+		}
+	}
+	return kernels->nombre;
+}
+
+/**
+* @brief Indica si los kernels elegidos son vectoriales.
+*
+* @return 1 si se eligio un juego de kernels distinto del escalar, 0 caso contrario.
+*/
+int
+simd_vectorial(void){
+	return kernels->autocorr != autocorrelacion_escalar;
+}
+
+/**
+* @brief Calcula la autocorrelacion normalizada de un vector con el kernel elegido.
+*
+* Misma interfaz y normalizacion que autocorrelacion().
+*
+* @param vector[] Vector a calcular la autocorrelacion.
+* @param len Longitud del vector.
+* @param num_lags Numero de desplazamientos a calcular, de 0 a num_lags-1. Como maximo len.
+* @param resultado[] Resultado del calculo.
+*/
+void
+autocorrelacion_simd(const float vector[], int len, int num_lags, float resultado[]){
+	kernels->autocorr(vector, len, num_lags, resultado);
+}
+
+/**
+* @brief Calcula el modulo de un lote de muestras I/Q con el kernel elegido.
+*
+* El resultado es identico al de llamar a valor_absoluto() con cada muestra.
+*
+* @param iq n pares I/Q intercalados. Puede no estar alineado a 4 bytes, como
+* las tablas de una captura mapeada.
+* @param n Numero de muestras.
+* @param modulo[] Modulo de cada muestra.
+*/
+void
+modulos_iq(const void *iq, int n, float modulo[]){
+	kernels->modulo(iq, n, modulo);
+}
+
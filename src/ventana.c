@@ -0,0 +1,157 @@
+/** @file ventana.c
+ *  @brief Autocorrelacion sobre una ventana deslizante de pulsos.
+ *
+ *  Las sumas se acumulan en doble precision: el producto de dos floats es
+ *  exacto en double, por lo que sumar y restar los aportes de cada pulso no
+ *  acumula error apreciable aun en ejecuciones largas.
+ *
+ *  @author Facundo Maero
+ */
+#include "../include/radar.h"
+#include "../include/ventana.h"
+#include <string.h>
+
+/**
+* @brief Reserva una ventana deslizante vacia.
+*
+* @param ventana Ventana a inicializar.
+* @param capacidad Numero de pulsos de la ventana.
+* @param max_lags Opcion -l (L+1), o 0 para calcular todos los desplazamientos.
+*/
+void
+crear_ventana(struct Ventana *ventana, int capacidad, int max_lags){
+	size_t n = (size_t)radar.num_gates * lags_calculados(capacidad, max_lags);
+	ventana->capacidad = capacidad;
+	ventana->num_lags = lags_calculados(capacidad, max_lags);
+	ventana->total = 0;
+	ventana->sumas_v = safe_malloc(sizeof(double) * n);
+	ventana->sumas_h = safe_malloc(sizeof(double) * n);
+	memset(ventana->sumas_v, 0, sizeof(double) * n);
+	memset(ventana->sumas_h, 0, sizeof(double) * n);
+}
+
+/**
+* @brief Libera la memoria de una ventana.
+*
+* @param ventana Ventana creada con crear_ventana().
+*/
+void
+liberar_ventana(struct Ventana *ventana){
+	free(ventana->sumas_v);
+	free(ventana->sumas_h);
+	ventana->sumas_v = NULL;
+	ventana->sumas_h = NULL;
+}
+
+/**
+* @brief Numero de pulsos que contiene la ventana.
+*
+* @param ventana Ventana deslizante.
+* @return min(total, capacidad).
+*/
+int
+pulsos_en_ventana(const struct Ventana *ventana){
+	return ventana->total < ventana->capacidad ? (int)ventana->total : ventana->capacidad;
+}
+
+/**
+* @brief Numero de desplazamientos que se emiten para la ventana.
+*
+* @param ventana Ventana deslizante.
+* @return min(pulsos_en_ventana(), num_lags).
+*/
+int
+lags_en_ventana(const struct Ventana *ventana){
+	int cantidad = pulsos_en_ventana(ventana);
+	return cantidad < ventana->num_lags ? cantidad : ventana->num_lags;
+}
+
+/**
+* @brief Agrega un pulso a una columna circular y actualiza sus sumas.
+*
+* Si la ventana esta llena, primero resta el aporte del pulso mas viejo, que
+* forma pares con todos los demas: columna[viejo]*columna[viejo+i] en el
+* desplazamiento i. Luego guarda el pulso nuevo en su lugar y suma sus pares
+* con los anteriores: valor*columna[n-i]. Los indices circulares se recorren en
+* dos tramos contiguos, sin calcular el modulo en cada iteracion.
+*
+* @param columna[] Buffer circular de capacidad modulos.
+* @param suma[] Sumas sin normalizar de cada desplazamiento.
+* @param capacidad Numero de pulsos de la ventana.
+* @param num_lags Numero de desplazamientos a actualizar.
+* @param n Numero del pulso a agregar, es decir, pulsos recibidos antes que el.
+* @param valor Modulo del pulso a agregar.
+*/
+static void
+desplazar_columna(float columna[], double suma[], int capacidad, int num_lags, long n, float valor){
+	int cantidad = n < capacidad ? (int)n : capacidad;
+	int s;
+
+	if(cantidad == capacidad){
+		double viejo = columna[n % capacidad];
+		s = n % capacidad;
+		//el pulso n - capacidad ocupa el mismo lugar que ocupara el pulso n
+		for (int i = 0; i < capacidad - s && i < num_lags; ++i)
+		{
+			suma[i] -= viejo * columna[s+i];
+		}
+		for (int i = capacidad - s; i < num_lags; ++i)
+		{
+			suma[i] -= viejo * columna[s+i-capacidad];
+		}
+		cantidad--;
+	}
+
+	s = n % capacidad;
+	columna[s] = valor;
+	if(cantidad >= num_lags) cantidad = num_lags - 1;
+	for (int i = 0; i <= cantidad && i <= s; ++i)
+	{
+		suma[i] += (double)valor * columna[s-i];
+	}
+	for (int i = s+1; i <= cantidad; ++i)
+	{
+		suma[i] += (double)valor * columna[s-i+capacidad];
+	}
+}
+
+/**
+* @brief Agrega el pulso n a la ventana de un gate.
+*
+* Los gates son independientes entre si, por lo que pueden actualizarse en
+* paralelo. Los pulsos de un mismo gate deben agregarse en orden.
+*
+* @param ventana Ventana deslizante.
+* @param gate Gate a actualizar, inicializado para ventana->capacidad pulsos.
+* @param indice_gate Numero del gate, para ubicar sus sumas.
+* @param n Numero del pulso a agregar.
+* @param valor_v Promedio de los modulos verticales del pulso en el gate.
+* @param valor_h Promedio de los modulos horizontales del pulso en el gate.
+*/
+void
+desplazar_gate(const struct Ventana *ventana, struct Gate *gate, int indice_gate, long n, float valor_v, float valor_h){
+	size_t base = (size_t)indice_gate * ventana->num_lags;
+	desplazar_columna(gate->absol_v, &ventana->sumas_v[base], ventana->capacidad, ventana->num_lags, n, valor_v);
+	desplazar_columna(gate->absol_h, &ventana->sumas_h[base], ventana->capacidad, ventana->num_lags, n, valor_h);
+}
+
+/**
+* @brief Calcula la autocorrelacion normalizada de la ventana de un gate.
+*
+* Igual que autocorrelacion(), divide cada suma por el numero de pulsos de la
+* ventana. Escribe lags_en_ventana() desplazamientos.
+*
+* @param ventana Ventana deslizante.
+* @param gate Gate donde guardar la autocorrelacion.
+* @param indice_gate Numero del gate, para ubicar sus sumas.
+*/
+void
+normalizar_gate(const struct Ventana *ventana, struct Gate *gate, int indice_gate){
+	size_t base = (size_t)indice_gate * ventana->num_lags;
+	int cantidad = pulsos_en_ventana(ventana);
+	for (int i = 0; i < lags_en_ventana(ventana); ++i)
+	{
+		gate->vector_autocorr_v[i] = ventana->sumas_v[base+i] / cantidad;
+		gate->vector_autocorr_h[i] = ventana->sumas_h[base+i] / cantidad;
+	}
+}